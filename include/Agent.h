@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentResultWriter.h"
+#include "SlotSandbox.h"
+#include "Socket.h"
+#include "TestExecutor.h"
+#include "TestRunner.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief 分布式模式的执行端：从协调者拉取批次，用本机的 TestExecutor 执行并回传结果
+ *
+ * 协议见 Coordinator。每个线程池线程对应一个槽位，每个空闲槽位向协调者发送一次 PULL，
+ * 批次内全部测例有结果后回复 DONE 并继续拉取。收到 REVOKE 时撤回其中尚未开始执行的测例。
+ */
+class Agent {
+  public:
+    /**
+     * @brief Construct a new Agent object
+     *
+     * @param config 使用 exe_path/out_dir/timeout_sec/dispatch_mode/sandbox，测例来自协调者
+     * @param host 协调者地址
+     * @param port 协调者端口
+     * @param thread_num 槽位数
+     * @param heartbeat_ms 心跳间隔，需小于协调者的超时时长
+     */
+    Agent(RunConfig const& config, std::string const& host, int port, int thread_num, int heartbeat_ms = 5000);
+
+    ~Agent();
+
+    /**
+     * @brief 执行直到协调者通知结束
+     *
+     * @return true 正常结束
+     * @return false 与协调者的连接中断
+     */
+    bool Run();
+
+  private:
+    /**
+     * @brief 单个测例结果回调，转发给协调者
+     *
+     * @param result
+     */
+    void OnResult(TestResult const& result);
+
+    /**
+     * @brief 撤回批次中尚未开始执行的测例并回复 REVOKED
+     *
+     * @param batch_id
+     * @param tests 协调者请求撤回的测例
+     */
+    void Revoke(int batch_id, std::vector<std::string> const& tests);
+
+    /**
+     * @brief 向协调者发送数据，可并发调用
+     *
+     * @param msg
+     */
+    void Send(std::string const& msg);
+
+    RunConfig config_;
+    int thread_num_;
+    int heartbeat_ms_;
+    Socket conn_;
+    ThreadPool pool_;
+    ConcurrentResultWriter writer_;
+    std::unique_ptr<SlotSandbox> sandbox_;
+    TestExecutor executor_;
+
+    std::mutex mtx_;
+    std::map<std::string, int> owner_;  // 测例 -> 所属批次
+    std::map<int, size_t> pending_;     // 批次 -> 尚未有结果的测例数
+
+    bool stop_ = false;
+    std::condition_variable stop_cv_;
+    std::thread heartbeat_thread_;
+};
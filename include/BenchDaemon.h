@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Socket.h"
+#include "TestPreprocess.h"
+#include "TestRunner.h"
+
+/**
+ * @brief 常驻模式：保持线程池、测例列表与耗时历史，测试程序重新生成后立即增量重跑
+ *
+ * 每轮运行先提交上一轮失败的测例，再按历史耗时从长到短提交其余测例。
+ * 结果逐条推送给连接到本地套接字的客户端，每行格式为：
+ *   RUN_START <total>
+ *   <test_name>\t<status>\t<duration_ms>
+ *   RUN_END <passed> <failed> <seconds>
+ *   RUN_ERROR <message>  本轮运行失败，代替 RUN_END，随后等待测试程序再次变化
+ * 推送由独立线程完成，测试线程只把行放入有界队列；长时间不读取的客户端被断开，
+ * 队列已满时新的结果行被丢弃，RUN_START/RUN_END/RUN_ERROR 始终保留。
+ * 结果文件 <out>/result.txt 只包含最近一轮的结果，上一轮的结果轮换为 result.prev.txt。
+ */
+class BenchDaemon {
+  public:
+    /**
+     * @brief Construct a new Bench Daemon object
+     *
+     * @param config 每轮运行的配置，test_names 与回调由常驻模式填写
+     * @param socket_path 推送结果的本地套接字路径
+     * @param thread_num
+     */
+    BenchDaemon(RunConfig const& config, std::string const& socket_path, int thread_num);
+
+    ~BenchDaemon();
+
+    /**
+     * @brief 运行一轮后持续监视测试程序，不会返回
+     *
+     */
+    void Run();
+
+  private:
+    /**
+     * @brief 重新获取测例并完整运行一轮
+     *
+     */
+    void RunOnce();
+
+    /**
+     * @brief 单个测例结果回调
+     *
+     * @param result
+     */
+    void OnResult(TestResult const& result);
+
+    /**
+     * @brief 接受客户端连接的线程函数
+     *
+     */
+    void AcceptClients();
+
+    /**
+     * @brief 将一行放入推送队列，不阻塞调用线程
+     *
+     * @param line
+     * @param control 为 true 时是 RUN_START/RUN_END/RUN_ERROR 控制行，队列已满也不丢弃
+     */
+    void Broadcast(std::string const& line, bool control = false);
+
+    /**
+     * @brief 推送线程函数，发送失败或超时的客户端被移除
+     *
+     */
+    void SendLines();
+
+    RunConfig config_;
+    TestPreprocess preprocess_;
+    TestRunner runner_;
+
+    std::unordered_map<std::string, long long> durations_ms_;  // 历史耗时，用于长测例优先
+    std::unordered_set<std::string> failing_;                  // 上一轮未通过的测例
+    std::mutex mtx_;
+
+    Socket listener_;
+    std::vector<Socket> clients_;
+    std::mutex clients_mtx_;
+    std::thread accept_thread_;
+
+    std::deque<std::string> outbox_;  // 待推送的行
+    std::mutex outbox_mtx_;
+    std::condition_variable outbox_cv_;
+    bool stopping_ = false;
+    std::thread sender_thread_;
+};
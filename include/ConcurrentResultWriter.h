@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <mutex>
 #include <sstream>
@@ -13,6 +14,7 @@ struct TestResult {
     std::string name;
     std::string status;
     std::string output;
+    long long duration_ms = 0;
 };
 
 class ConcurrentResultWriter {
@@ -34,6 +36,13 @@ class ConcurrentResultWriter {
 
     void AddResult(ExecuteResult const& result);
 
+    /**
+     * @brief 设置逐测例结果回调，在写入文件后于调用线程中触发
+     *
+     * @param listener
+     */
+    void SetListener(std::function<void(TestResult const&)> listener);
+
     /**
      * @brief 打印进度状态
      *
@@ -41,6 +50,7 @@ class ConcurrentResultWriter {
     void PrintProgress();
 
     std::mutex mtx_;
+    std::function<void(TestResult const&)> listener_;
     std::ofstream outfile_;
     std::atomic<int> total_;
     std::atomic<int> completed_;
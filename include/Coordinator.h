@@ -0,0 +1,131 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentResultWriter.h"
+#include "Socket.h"
+#include "TestRunner.h"
+
+/**
+ * @brief 分布式模式的协调者：负责获取测例与调度，测例由通过 TCP 连接的 Agent 执行
+ *
+ * 协议为按行分隔的文本，字段以制表符分隔：
+ *   Agent -> 协调者  HELLO <slots> | PULL | RESULT <batch>\t<test>\t<status>\t<ms> | DONE <batch> | REVOKED <batch>[\t<test>...] | PING
+ *   协调者 -> Agent  BATCH <batch>\t<test>... | REVOKE <batch>\t<test>... | BYE
+ * Agent 每个空闲槽位发送一次 PULL，协调者按剩余测例数与总槽位数逐步缩小批次（guided scheduling），
+ * 队列为空时挂起 PULL 直到有测例被重新入队或全部完成。连接断开、心跳超时或发送超时的 Agent 上未完成的测例重新入队。
+ * 队列为空而仍有挂起的 PULL 时，协调者向未完成测例最多的批次发送 REVOKE 取回其后一半测例，
+ * Agent 以 REVOKED 回复其中尚未开始执行的测例，这些测例放回队首交给空闲槽位（work stealing）。
+ */
+class Coordinator {
+  public:
+    /**
+     * @brief Construct a new Coordinator object
+     *
+     * @param config 使用 exe_path/gtest_filter/out_dir/batch_size/test_names 与回调
+     * @param port 监听端口
+     * @param agent_timeout_ms Agent 超过该时长没有任何消息即视为丢失
+     */
+    Coordinator(RunConfig const& config, int port, int agent_timeout_ms = 30000);
+
+    ~Coordinator();
+
+    /**
+     * @brief 获取测例并等待 Agent 执行完毕
+     *
+     * @return RunSummary
+     */
+    RunSummary Run();
+
+  private:
+    struct Batch {
+        std::vector<std::string> tests;  // 尚未有结果的测例
+        bool revoking = false;           // 已发送 REVOKE 尚未收到回复
+        bool stealable = true;           // 上次 REVOKE 未取回任何测例后不再尝试
+    };
+
+    struct AgentConn {
+        Socket socket;
+        int slots = 0;                   // 收到 HELLO 前不计入总槽位
+        int pending_pulls = 0;           // 尚未回复的 PULL 数
+        bool lost = false;               // 发送失败，已断开等待清理
+        std::map<int, Batch> in_flight;  // 已下发未完成的批次
+    };
+
+    /**
+     * @brief 接受 Agent 连接的线程函数
+     *
+     */
+    void AcceptAgents();
+
+    /**
+     * @brief 处理单个 Agent 消息的线程函数
+     *
+     * @param agent
+     */
+    void ServeAgent(std::shared_ptr<AgentConn> agent);
+
+    /**
+     * @brief 记录一条测例结果
+     *
+     * @param agent
+     * @param fields RESULT 行按制表符切分后的字段
+     */
+    void HandleResult(AgentConn& agent, std::vector<std::string> const& fields);
+
+    /**
+     * @brief 为挂起的 PULL 分配批次，调用者需持有 mtx_
+     *
+     */
+    void DispatchLocked();
+
+    /**
+     * @brief 队列为空时向未完成测例最多的批次请求撤回后一半测例，调用者需持有 mtx_
+     *
+     */
+    void StealLocked();
+
+    /**
+     * @brief 将 Agent 撤回的测例放回队首，调用者需持有 mtx_
+     *
+     * @param agent
+     * @param fields REVOKED 行按制表符切分后的字段
+     */
+    void HandleRevokedLocked(AgentConn& agent, std::vector<std::string> const& fields);
+
+    /**
+     * @brief 向 Agent 发送消息，发送超时或失败时断开连接，调用者需持有 mtx_
+     *
+     * @param agent
+     * @param msg
+     * @return true
+     * @return false 连接已断开，未完成的测例由该 Agent 的线程重新入队
+     */
+    bool SendLocked(AgentConn& agent, std::string const& msg);
+
+    RunConfig config_;
+    int agent_timeout_ms_;
+    ConcurrentResultWriter writer_;
+    Socket listener_;
+    std::thread accept_thread_;
+    std::vector<std::thread> agent_threads_;
+
+    std::mutex mtx_;
+    std::condition_variable done_cv_;
+    std::list<std::shared_ptr<AgentConn>> agents_;
+    std::deque<std::string> queue_;  // 尚未下发的测例
+    int next_batch_id_ = 0;
+    int total_slots_ = 0;
+    size_t total_ = 0;
+    size_t completed_ = 0;
+    bool finished_ = false;
+    RunSummary summary_;
+};
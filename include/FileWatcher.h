@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+/**
+ * @brief 监视一组文件，在文件被重新生成时唤醒调用者
+ *
+ * Linux 下基于 inotify，Windows 下基于 FindFirstChangeNotification。
+ * 监视的是文件所在目录，因此链接器先删除再重建文件的情况同样能被捕获。
+ */
+class FileWatcher {
+  public:
+    /**
+     * @brief Construct a new File Watcher object
+     *
+     * @param files 需要监视的文件
+     */
+    explicit FileWatcher(std::vector<std::filesystem::path> const& files);
+
+    FileWatcher(FileWatcher const&) = delete;
+    FileWatcher& operator=(FileWatcher const&) = delete;
+
+    ~FileWatcher();
+
+    /**
+     * @brief 阻塞等待任一被监视文件发生变化
+     *
+     * 构建过程中文件会被多次写入，因此在最后一次变化之后静默 settle 时长才返回，
+     * 避免在链接尚未完成时启动测试。
+     *
+     * @param settle 静默时长
+     */
+    void WaitForChange(std::chrono::milliseconds settle = std::chrono::milliseconds(500));
+
+  private:
+    /**
+     * @brief 等待一次与被监视文件相关的变化
+     *
+     * @param timeout 负数表示无限等待
+     * @return true 发生了变化
+     * @return false 超时
+     */
+    bool WaitEvent(std::chrono::milliseconds timeout);
+
+    std::vector<std::filesystem::path> files_;
+#ifdef _WIN32
+    std::vector<void*> handles_;                                // 每个目录一个变更通知句柄
+    std::vector<std::filesystem::file_time_type> write_times_;  // 目录通知不区分文件，比较修改时间
+#else
+    int inotify_fd_;
+#endif
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 单个测例的耗时分布
+ *
+ */
+struct DurationStats {
+    std::string name;
+    std::vector<double> samples_ms;
+    double mean_ms = 0;
+    double median_ms = 0;
+    double p95_ms = 0;
+    double variance = 0;
+
+    // 与基线比较的结果，无基线时 has_baseline 为 false
+    bool has_baseline = false;
+    double baseline_median_ms = 0;
+    double p_value = 1;
+    bool regressed = false;
+};
+
+/**
+ * @brief 重复运行的耗时统计与性能回退检测
+ *
+ * 每个测例的耗时样本与基线样本做单侧 Mann-Whitney U 检验（正态近似），
+ * p 值低于 alpha 且中位数变慢超过 threshold 时判定为回退。
+ * 报告为制表符分隔的文本，最后一列保存原始样本，可直接作为下一次比较的基线。
+ */
+class PerfReport {
+  public:
+    static constexpr size_t kMinSamples = 5;  // 两侧样本数均不少于该值时才进行检验，否则不判定回退
+
+    /**
+     * @brief 记录一个耗时样本，可并发调用
+     *
+     * @param name
+     * @param duration_ms
+     */
+    void AddSample(std::string const& name, double duration_ms);
+
+    /**
+     * @brief 读取基线报告
+     *
+     * @param path
+     */
+    void LoadBaseline(std::filesystem::path const& path);
+
+    /**
+     * @brief 基线样本数少于 kMinSamples 的测例数，这些测例无法判定回退
+     *
+     * @return size_t
+     */
+    size_t CountUnderSampledBaselines() const;
+
+    /**
+     * @brief 计算统计量并与基线比较
+     *
+     * @param alpha 显著性水平
+     * @param threshold 中位数相对变慢的最小比例
+     * @return std::vector<DurationStats> 按测例名排序
+     */
+    std::vector<DurationStats> Analyze(double alpha = 0.01, double threshold = 0.05) const;
+
+    /**
+     * @brief 写出报告
+     *
+     * @param path
+     * @param stats
+     */
+    static void Write(std::filesystem::path const& path, std::vector<DurationStats> const& stats);
+
+    /**
+     * @brief 单侧 Mann-Whitney U 检验，备择假设为 current 整体大于 baseline
+     *
+     * @param current
+     * @param baseline
+     * @return double p 值，任一侧样本数少于 kMinSamples 时为 1
+     */
+    static double MannWhitneyGreater(std::vector<double> const& current, std::vector<double> const& baseline);
+
+  private:
+    mutable std::mutex mtx_;
+    std::map<std::string, std::vector<double>> samples_;
+    std::map<std::string, std::vector<double>> baseline_;
+};
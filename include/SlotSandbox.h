@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+using EnvList = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief 沙箱目录的清理策略
+ *
+ */
+enum class SandboxCleanup {
+    kNever,     // 保留全部内容，便于排查
+    kPerBatch,  // 每组测例结束后清空所在槽位的目录
+    kOnExit,    // 运行结束后删除整个沙箱根目录
+};
+
+/**
+ * @brief 沙箱配置
+ *
+ */
+struct SandboxConfig {
+    bool enabled = false;
+    std::filesystem::path root;  // 沙箱根目录，为空时使用系统临时目录 (%TEMP%) 下的 ConcurBench
+    int port_base = 20000;       // 首选端口段起点，被本机其他实例占用时依次后移一段
+    int ports_per_slot = 100;
+    SandboxCleanup cleanup = SandboxCleanup::kPerBatch;
+    bool use_as_cwd = false;  // 子进程工作目录切换到槽位目录，测试依赖相对路径时保持关闭
+};
+
+/**
+ * @brief 按工作线程划分的测试沙箱
+ *
+ * 每个工作线程同一时刻只运行一个子进程，因此以线程编号作为槽位，槽位之间互不共享
+ * 临时目录、HOME 与端口范围，写固定临时文件或绑定固定端口的测试也能以满核并发运行。
+ * 子进程通过环境变量 CONCURBENCH_SLOT / CONCURBENCH_PORT_BASE / CONCURBENCH_PORT_COUNT 获取分配结果。
+ *
+ * 每个实例独占一个根目录，并占用 slot_count * ports_per_slot 个连续端口组成的端口段：
+ * 端口段 k 起始于 port_base + k * slot_count * ports_per_slot，通过系统临时目录下的锁文件在本机实例
+ * (包括同一进程中的多次运行与同一台机器上的多个 Agent) 之间互斥，进程退出时锁自动释放。
+ * 各实例需使用相同的 port_base 与段长，端口段才能严格互不重叠。
+ */
+class SlotSandbox {
+  public:
+    /**
+     * @brief Construct a new Slot Sandbox object
+     *
+     * @param config
+     * @param slot_count 槽位数，即线程池的线程数
+     * @throws std::runtime_error 端口段超出 65535 或全部被占用
+     */
+    SlotSandbox(SandboxConfig const& config, int slot_count);
+
+    SlotSandbox(SlotSandbox const&) = delete;
+    SlotSandbox& operator=(SlotSandbox const&) = delete;
+
+    ~SlotSandbox();
+
+    /**
+     * @brief 准备槽位目录并生成子进程需要覆盖的环境变量
+     *
+     * @param slot 取值范围 [0, slot_count)
+     * @return EnvList
+     */
+    EnvList Prepare(int slot);
+
+    /**
+     * @brief 一组测例结束，按清理策略处理槽位目录
+     *
+     * @param slot
+     */
+    void Release(int slot);
+
+    /**
+     * @brief 槽位目录
+     *
+     * @param slot
+     * @return std::filesystem::path
+     */
+    std::filesystem::path SlotDir(int slot) const;
+
+    bool UseAsCwd() const;
+
+    /**
+     * @brief 本实例占用的端口段起点，槽位 i 的端口范围为 [PortBase() + i * ports_per_slot, PortBase() + (i + 1) * ports_per_slot)
+     *
+     * @return int
+     */
+    int PortBase() const;
+
+  private:
+    /**
+     * @brief 依次尝试锁定端口段，成功时设置 port_base_ 与 port_lock_
+     *
+     */
+    void ReservePorts();
+
+    SandboxConfig config_;
+    int slot_count_;
+    std::filesystem::path root_;
+    int port_base_;
+    std::intptr_t port_lock_;  // 端口段锁文件的句柄，析构时关闭以释放端口段
+};
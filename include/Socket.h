@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+/**
+ * @brief 跨平台流式套接字的最小封装，只提供本工具需要的功能
+ *
+ */
+class Socket {
+  public:
+#ifdef _WIN32
+    using Native = std::uintptr_t;  // 对应 winsock 的 SOCKET
+#else
+    using Native = int;
+#endif
+
+    Socket() = default;
+    explicit Socket(Native fd);
+    Socket(Socket&& other) noexcept;
+    Socket& operator=(Socket&& other) noexcept;
+    Socket(Socket const&) = delete;
+    Socket& operator=(Socket const&) = delete;
+    ~Socket();
+
+    /**
+     * @brief 在本地套接字路径上监听，上一次运行残留的套接字文件会被删除
+     *
+     * @param path
+     * @return Socket
+     * @throws std::runtime_error 路径上已存在套接字以外的文件
+     */
+    static Socket ListenLocal(std::string const& path);
+
+    /**
+     * @brief 在全部网卡的指定端口上监听 TCP 连接
+     *
+     * @param port
+     * @return Socket
+     */
+    static Socket ListenTcp(int port);
+
+    /**
+     * @brief 连接 TCP 服务端
+     *
+     * @param host 主机名或地址
+     * @param port
+     * @return Socket
+     */
+    static Socket ConnectTcp(std::string const& host, int port);
+
+    /**
+     * @brief 阻塞等待新连接，监听套接字被 Shutdown 后返回无效套接字
+     *
+     * @return Socket
+     */
+    Socket Accept();
+
+    /**
+     * @brief 发送全部数据
+     *
+     * @param data
+     * @return true 发送成功
+     * @return false 对端已断开
+     */
+    bool SendAll(std::string const& data);
+
+    /**
+     * @brief 读取一行，不含行尾换行符
+     *
+     * @param line
+     * @return true 读取成功
+     * @return false 对端已断开、出错或超时
+     */
+    bool ReadLine(std::string& line);
+
+    /**
+     * @brief 设置接收超时，超时后 ReadLine 返回 false
+     *
+     * @param timeout_ms 0 表示不超时
+     */
+    void SetRecvTimeout(int timeout_ms);
+
+    /**
+     * @brief 设置发送超时，对端长时间不读取时 SendAll 返回 false
+     *
+     * @param timeout_ms 0 表示不超时
+     */
+    void SetSendTimeout(int timeout_ms);
+
+    /**
+     * @brief 关闭读写方向，唤醒阻塞在该套接字上的 Accept/Recv
+     *
+     * Winsock 中 shutdown 对监听套接字无效 (WSAENOTCONN)，阻塞的 accept 不会返回，
+     * 此时直接关闭句柄唤醒 accept，句柄值保留到 Close 时不再重复关闭。
+     */
+    void Shutdown();
+
+    void Close();
+
+    bool Valid() const;
+
+  private:
+    Native fd_ = kInvalid;
+    bool closed_ = false;  // 句柄已在 Shutdown 中关闭，fd_ 仅保留给仍阻塞在其上的线程
+    std::string buffer_;  // ReadLine 已接收但尚未返回的数据
+
+#ifdef _WIN32
+    static constexpr Native kInvalid = ~static_cast<Native>(0);
+#else
+    static constexpr Native kInvalid = -1;
+#endif
+};
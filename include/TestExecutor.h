@@ -1,9 +1,17 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "SlotSandbox.h"
 #include "ThreadPool.h"
 
 class ConcurrentResultWriter;
@@ -16,6 +24,18 @@ struct ExecuteResult {
     std::vector<std::string> timed_out_tests;
     std::vector<std::string> remaining_tests;
     std::vector<std::string> interrupted_tests;
+    std::vector<std::string> cancelled_tests;
+    std::unordered_map<std::string, long long> durations_ms;  // gtest 报告的测例耗时
+};
+
+/**
+ * @brief 测例下发方式
+ *
+ */
+enum class DispatchMode {
+    kFilter,    // 全部测例名拼接为一个 --gtest_filter 参数
+    kFlagFile,  // 过滤条件写入临时文件，通过 --gtest_flagfile 传递，避免命令行超长
+    kShard,     // 使用 gtest 原生分片 GTEST_TOTAL_SHARDS / GTEST_SHARD_INDEX，子进程无需匹配长过滤列表
 };
 
 class TestExecutor {
@@ -27,8 +47,9 @@ class TestExecutor {
      * @param exe_path
      * @param writer
      * @param timeout_sec
+     * @param mode 测例下发方式
      */
-    TestExecutor(ThreadPool& pool, std::string const& exe_path, ConcurrentResultWriter& writer, int timeout_sec = 30);
+    TestExecutor(ThreadPool& pool, std::string const& exe_path, ConcurrentResultWriter& writer, int timeout_sec = 30, DispatchMode mode = DispatchMode::kFlagFile);
 
     /**
      * @brief 向进程池提交一组测例，交由一个线程执行
@@ -37,6 +58,18 @@ class TestExecutor {
      */
     void SubmitTestBatch(std::vector<std::string> const& test_names);
 
+    /**
+     * @brief 按 gtest 原生分片提交测例，每个分片交由一个线程执行
+     *
+     * 子进程只接收原始的 gtest_filter 与分片环境变量，以子进程实际报告的测例为准并跨分片去重。
+     * 没有任何分片执行的测例回退为 kFlagFile 方式重新提交。
+     *
+     * @param test_names gtest_filter 对应的全部测例
+     * @param gtest_filter
+     * @param total_shards
+     */
+    void SubmitShards(std::vector<std::string> const& test_names, std::string const& gtest_filter, int total_shards);
+
     /**
      * @brief 生成command
      *
@@ -45,17 +78,117 @@ class TestExecutor {
      */
     std::string BuildCommand(std::vector<std::string> const& test_names);
 
+    /**
+     * @brief 生成通过 flagfile 传递过滤条件的command
+     *
+     * @param flag_file
+     * @return std::string
+     */
+    std::string BuildFlagFileCommand(std::filesystem::path const& flag_file);
+
+    /**
+     * @brief 将测例过滤条件写入临时 flagfile
+     *
+     * @param test_names
+     * @return std::filesystem::path 临时文件路径，由调用者负责删除
+     */
+    std::filesystem::path WriteFlagFile(std::vector<std::string> const& test_names);
+
     /**
      * @brief 执行任务
      *
      * @param command
+     * @param test_names
+     * @param env 需要覆盖的环境变量，为空且未启用沙箱时继承父进程环境
      * @return ExecuteResult
      */
-    ExecuteResult ExecuteTest(std::string const& command, std::vector<std::string> const& test_names);
+    ExecuteResult ExecuteTest(std::string const& command, std::vector<std::string> const& test_names, EnvList const& env = {});
+
+    /**
+     * @brief 为子进程启用按工作线程划分的沙箱，需在提交任务前设置
+     *
+     * @param sandbox 为空时子进程共享父进程的工作目录与环境
+     */
+    void SetSandbox(SlotSandbox* sandbox);
+
+    /**
+     * @brief 取消执行：终止正在运行的子进程，尚未完成的测例记为 Cancelled
+     *
+     */
+    void Cancel();
+
+    /**
+     * @brief 阻塞直到已提交的全部任务处理完毕，包括重新提交的剩余测例
+     *
+     */
+    void WaitIdle();
+
+    /**
+     * @brief 撤回已提交但尚未开始执行的测例，被撤回的测例不会产生结果
+     *
+     * 尚未启动的任务在启动前剔除这些测例；子进程开始执行被撤回的测例时立即终止，
+     * 其余未执行的测例重新提交。
+     *
+     * @param test_names 调用者需保证这些测例已提交且尚无结果
+     * @return std::vector<std::string> 实际撤回的测例，已经开始执行的测例不会被撤回
+     */
+    std::vector<std::string> Revoke(std::vector<std::string> const& test_names);
 
   private:
+    /**
+     * @brief 向线程池提交任务并计数，任务抛出异常时整组测例记为中断
+     *
+     * @param test_names
+     * @param run
+     */
+    void Enqueue(std::vector<std::string> const& test_names, std::function<ExecuteResult()> run);
+
+    /**
+     * @brief 按当前下发方式执行一组测例，已撤回的测例不会启动
+     *
+     * @param batch
+     * @return ExecuteResult
+     */
+    ExecuteResult RunBatch(std::vector<std::string> const& batch);
+
+    /**
+     * @brief 记录结果，并重新提交剩余测例
+     *
+     * @param test_names 本次下发的测例
+     * @param result
+     */
+    void HandleResult(std::vector<std::string> const& test_names, ExecuteResult& result);
+
+    /**
+     * @brief 剔除已撤回的测例，剔除后撤回即失效
+     *
+     * @param test_names
+     * @return std::vector<std::string> 未被撤回的测例
+     */
+    std::vector<std::string> DropRevoked(std::vector<std::string> const& test_names);
+
+    /**
+     * @brief 子进程开始执行某个测例时调用
+     *
+     * @param test_name
+     * @return true 测例未被撤回，记为已开始
+     * @return false 测例已被撤回，撤回随之失效
+     */
+    bool MarkStarted(std::string const& test_name);
+
     ThreadPool& pool_;
     std::string exe_path_;
     ConcurrentResultWriter& writer_;
     int time_out_;
+    DispatchMode mode_;
+    SlotSandbox* sandbox_;
+    std::filesystem::path flag_dir_;
+    inline static std::atomic<unsigned long long> flag_seq_{0};  // 进程内全部执行器共享，同一进程中的多次运行不会写同一个 flagfile
+    std::atomic<bool> cancelled_;
+    int pending_;  // 已提交尚未处理完的任务数
+    std::mutex pending_mtx_;
+    std::condition_variable idle_cv_;
+    std::unordered_set<std::string> started_;  // 已开始执行尚未记录结果的测例
+    std::unordered_set<std::string> revoked_;  // 已撤回尚未从任务中剔除的测例
+    std::mutex revoke_mtx_;
 };
\ No newline at end of file
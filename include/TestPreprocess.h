@@ -30,6 +30,13 @@ class TestPreprocess {
      */
     void GetTests();
 
+    /**
+     * @brief 读取 GetTests 写入的测例列表
+     *
+     * @return std::vector<std::string>
+     */
+    std::vector<std::string> ReadTests() const;
+
     /**
      * @brief 获得全部的tests name
      *
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentResultWriter.h"
+#include "SlotSandbox.h"
+#include "TestExecutor.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief 一次运行的汇总结果
+ *
+ */
+struct RunSummary {
+    size_t total = 0;
+    size_t passed = 0;
+    size_t failed = 0;
+    size_t skipped = 0;
+    size_t timed_out = 0;
+    size_t interrupted = 0;
+    size_t cancelled = 0;
+    double seconds = 0;
+
+    /**
+     * @brief 按测例状态计数
+     *
+     * @param status
+     */
+    void Record(std::string const& status);
+};
+
+/**
+ * @brief 一次运行的配置
+ *
+ */
+struct RunConfig {
+    std::string exe_path;
+    std::string gtest_filter = "*";
+    std::filesystem::path out_dir;  // 测例列表与结果文件所在目录，为空时使用测试程序目录下的 output
+    int timeout_sec = 30;
+    size_t batch_size = 0;  // 每组测例数，0 表示按 测例数/线程数/10 计算
+    DispatchMode dispatch_mode = DispatchMode::kFlagFile;
+    int repeat = 1;  // 每个测例的运行次数，各轮在线程间并行，用于采集耗时分布
+    SandboxConfig sandbox;  // 按工作线程划分的沙箱，默认关闭
+
+    std::vector<std::string> test_names;  // 指定要运行的测例及提交顺序，为空时按 gtest_filter 获取
+
+    std::function<void(TestResult const&)> on_result;    // 逐测例回调，在工作线程中并发触发
+    std::function<void(RunSummary const&)> on_complete;  // 运行结束回调，在 future 就绪前触发
+    // 回调可以捕获 RunHandle，运行结束后驱动线程释放回调，不会形成引用环
+};
+
+struct RunState;
+
+/**
+ * @brief 异步运行的句柄，可复制，全部副本销毁时取消尚未结束的运行
+ *
+ * 销毁句柄不等待运行退出，运行状态由驱动线程持有到运行结束，因此回调中也可以持有和释放句柄。
+ */
+class RunHandle {
+  public:
+    /**
+     * @brief 阻塞等待运行结束
+     *
+     * @return RunSummary 运行失败时抛出获取测例过程中的异常
+     */
+    RunSummary Wait() const;
+
+    /**
+     * @brief 在给定时间内等待运行结束
+     *
+     * @param timeout
+     * @return true 运行已结束
+     */
+    bool WaitFor(std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief 运行结束时就绪的 future
+     *
+     * @return std::shared_future<RunSummary>
+     */
+    std::shared_future<RunSummary> Future() const;
+
+    /**
+     * @brief 取消运行，正在执行的子进程被终止，其余测例记为 Cancelled
+     *
+     */
+    void Cancel();
+
+    /**
+     * @brief 已处理的测例数
+     */
+    int Completed() const;
+
+    /**
+     * @brief 测例总数，获取测例完成前为 0
+     */
+    int Total() const;
+
+  private:
+    friend class TestRunner;
+
+    explicit RunHandle(std::shared_ptr<RunState> state);
+
+    std::shared_ptr<RunState> state_;
+};
+
+/**
+ * @brief 测试运行器，持有可在多次运行间复用的线程池
+ *
+ */
+class TestRunner {
+  public:
+    /**
+     * @brief Construct a new Test Runner object
+     *
+     * @param thread_num 线程池线程数
+     */
+    explicit TestRunner(int thread_num = static_cast<int>(std::thread::hardware_concurrency()));
+
+    /**
+     * @brief 异步开始一次运行，立即返回
+     *
+     * @param config
+     * @return RunHandle
+     */
+    RunHandle Start(RunConfig const& config);
+
+  private:
+    int thread_num_;
+    std::shared_ptr<ThreadPool> pool_;  // 运行状态同样持有，保证任务执行期间线程池有效
+};
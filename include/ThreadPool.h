@@ -58,6 +58,13 @@ class ThreadPool {
      */
     ~ThreadPool();
 
+    /**
+     * @brief 当前线程在所属线程池中的编号
+     *
+     * @return int 取值 [0, threads)，非工作线程返回 -1
+     */
+    static int CurrentWorkerIndex();
+
   private:
     std::vector<std::thread> workers;         // 工作线程容器
     std::queue<std::function<void()>> tasks;  // 任务队列
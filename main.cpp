@@ -1,72 +1,280 @@
-#include <filesystem>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
-#include "ConcurrentResultWriter.h"
-#include "TestExecutor.h"
-#include "TestPreprocess.h"
-#include "ThreadPool.h"
+#include "Agent.h"
+#include "BenchDaemon.h"
+#include "Coordinator.h"
+#include "PerfReport.h"
+#include "TestRunner.h"
 // 耦合版本
 // IntersectorCoroutineBatchTests*:IntersectorGeometryCoroutineBatchTests*:Intersector_SliceGeneratorBatchTests*:
 // Spd_IntersectorSpdPrimtiveGeneratorBatchTests*:IntersectorSpdModelGeneratorBatchTests*:IntersectorSpdBoatGeneratorBatchTests*
 // 独立版本
 // IntersectorCoroutineBatchTests*:IntersectorGeometryCoroutineBatchTests*:IntersectorSliceGeneratorBatchTests*:IntersectorSpdPrimtiveGeneratorBatchTests*:IntersectorSpdModelGeneratorBatchTests*:IntersectorSpdBoatGeneratorBatchTests*
-int main() {
-    // 1. 可执行文件路径
-    std::string exe_path = "D:/GithubProject/GME-Test/GME-Build/Release/tests.exe";
-    // 2. gtest_filter
-    std::string gtest_filter =
-      "IntersectorCoroutineBatchTests*:IntersectorGeometryCoroutineBatchTests*:IntersectorSliceGeneratorBatchTests*:IntersectorSpdPrimtiveGeneratorBatchTests*:IntersectorSpdModelGeneratorBatchTests*:IntersectorSpdBoatGeneratorBatchTests*";
-    // 3. 超时上限
-    int time_out_sec = 30;
-    int thread_num = std::thread::hardware_concurrency();
 
-    std::filesystem::path parent_dir = std::filesystem::path(exe_path).parent_path();
-    std::filesystem::path out_path = parent_dir / "output";
-    std::filesystem::create_directory(out_path);
-    std::string test_list_file = out_path.string() + "/test_name.txt";
-    std::string result_file = out_path.string() + "/result.txt";
+namespace {
+    void PrintUsage() {
+        std::cerr << "用法: ConcurBench [选项] <exe_path> [gtest_filter]\n"
+                     "  --timeout <sec>              单个测例超时上限，默认 30\n"
+                     "  --threads <n>                并发线程数，默认硬件并发数\n"
+                     "  --batch <n>                  每组测例数，默认 测例数/线程数/10\n"
+                     "  --dispatch <mode>            测例下发方式 filter | flagfile | shard，默认 flagfile\n"
+                     "  --out <dir>                  输出目录，默认测试程序目录下的 output\n"
+                     "  --daemon                     常驻模式，测试程序重新生成后自动重跑\n"
+                     "  --socket <path>              常驻模式推送结果的本地套接字，默认 <out>/concurbench.sock\n"
+                     "  --repeat <n>                 性能模式：每个测例运行 n 次并统计耗时分布，仅用于单机运行\n"
+                     "  --baseline <file>            性能模式：与之前的报告比较，检测显著变慢的测例，需要 --repeat 不少于 5\n"
+                     "  --report <file>              性能模式报告，默认 <out>/perf_report.tsv\n"
+                     "  --alpha <p>                  性能模式显著性水平，默认 0.01\n"
+                     "  --threshold <r>              性能模式中位数变慢的最小比例，默认 0.05\n"
+                     "  --sandbox                    每个工作线程使用独立的临时目录、HOME 与端口范围\n"
+                     "  --sandbox-root <dir>         沙箱根目录，默认 %TEMP%\\ConcurBench\n"
+                     "  --sandbox-cleanup <policy>   never | batch | exit，默认 batch\n"
+                     "  --sandbox-cwd                子进程工作目录切换到槽位目录\n"
+                     "  --port-base <n>              槽位端口段起点，被本机其他实例占用时依次后移，默认 20000\n"
+                     "  --ports-per-slot <n>         每个槽位的端口数，默认 100\n"
+                     "  --coordinator <port>         分布式模式：获取测例并调度给连接到该端口的 Agent\n"
+                     "  --agent <host:port>          分布式模式：连接协调者，用本机的 exe_path 执行分配到的测例\n";
+    }
+
+    /**
+     * @brief 解析数值参数，整个字符串都是数字时才成功
+     */
+    bool ParseNumber(char const* text, double& value) {
+        char* end = nullptr;
+        value = std::strtod(text, &end);
+        return end != text && *end == '\0';
+    }
 
-    TestPreprocess tp(gtest_filter, exe_path, test_list_file);
-    tp.GetTests();
+    bool ParseNumber(char const* text, int& value) {
+        char* end = nullptr;
+        long parsed = std::strtol(text, &end, 10);
+        value = static_cast<int>(parsed);
+        return end != text && *end == '\0' && parsed == value;
+    }
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    RunConfig config;
+    int thread_num = static_cast<int>(std::thread::hardware_concurrency());
+    bool daemon_mode = false;
+    std::string socket_path;
+    std::filesystem::path baseline_path;
+    std::filesystem::path report_path;
+    double alpha = 0.01;
+    double threshold = 0.05;
+    int coordinator_port = 0;
+    std::string agent_address;
+
+    std::vector<std::string> positional;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--timeout" && has_value)
+            config.timeout_sec = std::atoi(argv[++i]);
+        else if(arg == "--threads" && has_value)
+            thread_num = std::atoi(argv[++i]);
+        else if(arg == "--batch" && has_value)
+            config.batch_size = static_cast<size_t>(std::atoll(argv[++i]));
+        else if(arg == "--out" && has_value)
+            config.out_dir = argv[++i];
+        else if(arg == "--socket" && has_value)
+            socket_path = argv[++i];
+        else if(arg == "--baseline" && has_value)
+            baseline_path = argv[++i];
+        else if(arg == "--report" && has_value)
+            report_path = argv[++i];
+        else if(arg == "--sandbox")
+            config.sandbox.enabled = true;
+        else if(arg == "--sandbox-root" && has_value)
+            config.sandbox.root = argv[++i];
+        else if(arg == "--sandbox-cwd")
+            config.sandbox.use_as_cwd = true;
+        else if(arg == "--port-base" && has_value)
+            config.sandbox.port_base = std::atoi(argv[++i]);
+        else if(arg == "--ports-per-slot" && has_value)
+            config.sandbox.ports_per_slot = std::atoi(argv[++i]);
+        else if(arg == "--coordinator" && has_value)
+            coordinator_port = std::atoi(argv[++i]);
+        else if(arg == "--agent" && has_value)
+            agent_address = argv[++i];
+        else if(arg == "--daemon")
+            daemon_mode = true;
+        else if(arg == "--dispatch" && has_value) {
+            std::string mode = argv[++i];
+            if(mode == "filter")
+                config.dispatch_mode = DispatchMode::kFilter;
+            else if(mode == "flagfile")
+                config.dispatch_mode = DispatchMode::kFlagFile;
+            else if(mode == "shard")
+                config.dispatch_mode = DispatchMode::kShard;
+            else {
+                PrintUsage();
+                return 2;
+            }
+        } else if(arg == "--sandbox-cleanup" && has_value) {
+            std::string policy = argv[++i];
+            if(policy == "never")
+                config.sandbox.cleanup = SandboxCleanup::kNever;
+            else if(policy == "batch")
+                config.sandbox.cleanup = SandboxCleanup::kPerBatch;
+            else if(policy == "exit")
+                config.sandbox.cleanup = SandboxCleanup::kOnExit;
+            else {
+                PrintUsage();
+                return 2;
+            }
+        } else if((arg == "--repeat" || arg == "--alpha" || arg == "--threshold") && has_value) {
+            std::string value = argv[++i];
+            bool valid = arg == "--repeat" ? ParseNumber(value.c_str(), config.repeat) : ParseNumber(value.c_str(), arg == "--alpha" ? alpha : threshold);
+            if(!valid) {
+                std::cerr << arg << " 需要数值，而不是 " << value << "\n";
+                return 2;
+            }
+        } else if(arg.rfind("--", 0) == 0) {
+            PrintUsage();
+            return 2;
+        } else
+            positional.push_back(arg);
+    }
+    if(positional.empty() || positional.size() > 2 || thread_num <= 0) {
+        PrintUsage();
+        return 2;
+    }
+    // 超出范围的参数会使检验永远 (或总是) 判定为回退，或使性能模式静默关闭
+    if(config.repeat < 1) {
+        std::cerr << "--repeat 需要不小于 1\n";
+        return 2;
+    }
+    if(!(alpha > 0 && alpha < 1)) {
+        std::cerr << "--alpha 需要在 (0, 1) 之间\n";
+        return 2;
+    }
+    if(!(threshold >= 0) || !std::isfinite(threshold)) {
+        std::cerr << "--threshold 需要为非负数\n";
+        return 2;
+    }
+    // 性能模式只在单机的一次运行中采集耗时，分布式与常驻模式不会生成报告
+    bool perf_requested = config.repeat != 1 || !baseline_path.empty() || !report_path.empty();
+    if(perf_requested && (daemon_mode || coordinator_port > 0 || !agent_address.empty())) {
+        std::cerr << "--repeat/--baseline/--report 不能与 --daemon/--coordinator/--agent 同时使用\n";
+        return 2;
+    }
+    // 样本过少时检验没有足够的功效，任何测例都不会被判定为回退
+    if(!baseline_path.empty() && config.repeat < static_cast<int>(PerfReport::kMinSamples)) {
+        std::cerr << "--baseline 需要 --repeat 不少于 " << PerfReport::kMinSamples << "\n";
+        return 2;
+    }
 
-    // 读取测试列表
-    std::vector<std::string> test_names;
-    {
-        std::ifstream infile(test_list_file);
-        std::string line;
-        while(std::getline(infile, line)) {
-            if(!line.empty()) test_names.push_back(line);
+    // 每个实例占用 threads * ports_per_slot 个连续端口
+    if(config.sandbox.enabled && (config.sandbox.port_base <= 0 || config.sandbox.ports_per_slot <= 0 || config.sandbox.port_base + static_cast<long long>(thread_num) * config.sandbox.ports_per_slot - 1 > 65535)) {
+        std::cerr << "--port-base + --threads * --ports-per-slot 超出端口范围 65535\n";
+        return 2;
+    }
+    config.exe_path = positional[0];
+    if(positional.size() == 2) config.gtest_filter = positional[1];
+    if(config.out_dir.empty()) config.out_dir = std::filesystem::path(config.exe_path).parent_path() / "output";
+
+    if(!agent_address.empty()) {
+        size_t colon = agent_address.rfind(':');
+        if(colon == std::string::npos) {
+            PrintUsage();
+            return 2;
+        }
+        // 协调者不可达等错误
+        try {
+            Agent agent(config, agent_address.substr(0, colon), std::atoi(agent_address.c_str() + colon + 1), thread_num);
+            return agent.Run() ? 0 : 1;
+        } catch(std::exception const& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
         }
     }
 
-    // 初始化组件
-    ThreadPool pool(thread_num);
-    ConcurrentResultWriter writer(result_file);
-    TestExecutor executor(pool, exe_path, writer, time_out_sec);
+    if(coordinator_port > 0) {
+        // 端口被占用、获取测例失败等错误
+        RunSummary summary;
+        try {
+            Coordinator coordinator(config, coordinator_port);
+            std::cout << "Waiting for agents on port " << coordinator_port << "...\n";
+            summary = coordinator.Run();
+        } catch(std::exception const& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        std::cout << "\nAll tests completed!\n";
+        std::cout << "Passed: " << summary.passed << ", Failed: " << summary.failed << ", Skipped: " << summary.skipped << ", Timed out: " << summary.timed_out << ", Interrupted: " << summary.interrupted << "\n";
+        std::cout << "总耗时：" << summary.seconds << "秒";
+        return summary.failed + summary.timed_out + summary.interrupted == 0 ? 0 : 1;
+    }
 
-    writer.total_ = static_cast<int>(test_names.size());
+    if(daemon_mode) {
+        if(socket_path.empty()) socket_path = (config.out_dir / "concurbench.sock").string();
+        // 套接字路径被占用等错误，单次运行的错误由 BenchDaemon::Run 自行处理
+        try {
+            std::filesystem::create_directories(config.out_dir);
+            BenchDaemon daemon(config, socket_path, thread_num);
+            daemon.Run();
+        } catch(std::exception const& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
 
-    auto start_time = std::chrono::steady_clock::now();
-    // 提交任务, 一组M个
-    const int M = static_cast<int>(test_names.size()) / thread_num / 10;
-    std::vector<std::string> batch;
-    for(int i = 0; i < test_names.size(); i++) {
-        batch.push_back(test_names[i]);
-        if(i && i % M == 0 || i == test_names.size() - 1) {
-            executor.SubmitTestBatch(batch);
-            batch.clear();
+    // 性能模式：只采集通过的测例的耗时
+    bool perf_mode = config.repeat > 1 || !baseline_path.empty();
+    PerfReport perf;
+    if(perf_mode) {
+        if(!baseline_path.empty()) {
+            try {
+                perf.LoadBaseline(baseline_path);
+            } catch(std::exception const& e) {
+                std::cerr << e.what() << "\n";
+                return 2;
+            }
+            size_t under_sampled = perf.CountUnderSampledBaselines();
+            if(under_sampled > 0) std::cerr << "警告：基线中 " << under_sampled << " 个测例的样本数少于 " << PerfReport::kMinSamples << "，无法判定这些测例是否变慢\n";
         }
+        config.on_result = [&perf](TestResult const& result) {
+            if(result.status == "Passed") perf.AddSample(result.name, static_cast<double>(result.duration_ms));
+        };
     }
 
-    // 等待任务完成
-    while(writer.completed_ < test_names.size()) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        writer.PrintProgress();
+    // 没有空闲的沙箱端口段、获取测例失败等错误
+    TestRunner runner(thread_num);
+    RunSummary summary;
+    try {
+        RunHandle handle = runner.Start(config);
+
+        // 每秒刷新一次进度，运行结束时立即返回
+        while(!handle.WaitFor(std::chrono::seconds(1))) {
+            std::cout << "\rProgress: " << handle.Completed() << "/" << handle.Total() << std::flush;
+        }
+        summary = handle.Wait();
+    } catch(std::exception const& e) {
+        std::cerr << "\n" << e.what() << "\n";
+        return 1;
     }
-    auto total_time = std::chrono::steady_clock::now() - start_time;
-    auto seconds_float = std::chrono::duration<double>(total_time).count();
+    std::cout << "\rProgress: " << summary.total << "/" << summary.total;
     std::cout << "\nAll tests completed!\n";
-    std::cout << "总耗时：" << seconds_float << "秒";
+    std::cout << "Passed: " << summary.passed << ", Failed: " << summary.failed << ", Skipped: " << summary.skipped << ", Timed out: " << summary.timed_out << ", Interrupted: " << summary.interrupted << "\n";
+    std::cout << "总耗时：" << summary.seconds << "秒";
+
+    size_t regressions = 0;
+    if(perf_mode) {
+        if(report_path.empty()) report_path = config.out_dir / "perf_report.tsv";
+        auto stats = perf.Analyze(alpha, threshold);
+        PerfReport::Write(report_path, stats);
+        for(auto const& s: stats) {
+            if(!s.regressed) continue;
+            regressions++;
+            std::cout << "\n[REGRESSED] " << s.name << ": median " << s.baseline_median_ms << "ms -> " << s.median_ms << "ms, p=" << s.p_value;
+        }
+        std::cout << "\n性能报告：" << report_path.string() << "，显著变慢的测例：" << regressions;
+    }
 
-    return 0;
-}
\ No newline at end of file
+    return summary.failed + summary.timed_out + summary.interrupted + regressions == 0 ? 0 : 1;
+}
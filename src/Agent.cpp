@@ -0,0 +1,186 @@
+#include "Agent.h"
+
+#include <sstream>
+
+namespace {
+    /**
+     * @brief 补全输出目录，Agent 的结果另存一份在本机便于排查
+     */
+    std::filesystem::path AgentResultFile(RunConfig const& config) {
+        std::filesystem::path out_dir = config.out_dir.empty() ? std::filesystem::path(config.exe_path).parent_path() / "output" : config.out_dir;
+        std::filesystem::create_directories(out_dir);
+        return out_dir / "agent_result.txt";
+    }
+
+    /**
+     * @brief 解析 BATCH/REVOKE 的参数部分：批次编号与测例
+     */
+    int ParseBatch(std::string const& args, std::vector<std::string>& tests) {
+        std::istringstream iss(args);
+        std::string field;
+        std::getline(iss, field, '\t');
+        int batch_id = std::atoi(field.c_str());
+        while(std::getline(iss, field, '\t')) {
+            if(!field.empty()) tests.push_back(field);
+        }
+        return batch_id;
+    }
+}  // namespace
+
+/**
+ * @brief Construct a new Agent object
+ *
+ * @param config
+ * @param host
+ * @param port
+ * @param thread_num
+ * @param heartbeat_ms
+ */
+Agent::Agent(RunConfig const& config, std::string const& host, int port, int thread_num, int heartbeat_ms):
+    config_(config),
+    thread_num_(thread_num),
+    heartbeat_ms_(heartbeat_ms),
+    conn_(Socket::ConnectTcp(host, port)),
+    pool_(thread_num),
+    writer_(AgentResultFile(config).string()),
+    executor_(pool_, config.exe_path, writer_, config.timeout_sec, config.dispatch_mode == DispatchMode::kShard ? DispatchMode::kFlagFile : config.dispatch_mode) {
+    // 批次由协调者按名单下发，不能使用依赖完整过滤顺序的 gtest 分片
+    writer_.total_ = 0;
+    writer_.completed_ = 0;
+    writer_.SetListener([this](TestResult const& result) { OnResult(result); });
+    if(config_.sandbox.enabled) {
+        sandbox_ = std::make_unique<SlotSandbox>(config_.sandbox, thread_num_);
+        executor_.SetSandbox(sandbox_.get());
+    }
+}
+
+Agent::~Agent() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    stop_cv_.notify_all();
+    if(heartbeat_thread_.joinable()) heartbeat_thread_.join();
+}
+
+/**
+ * @brief 执行直到协调者通知结束
+ *
+ * @return true
+ * @return false
+ */
+bool Agent::Run() {
+    // 每个槽位预先拉取一个批次
+    std::string hello = "HELLO " + std::to_string(thread_num_) + "\n";
+    for(int i = 0; i < thread_num_; i++) hello += "PULL\n";
+    Send(hello);
+
+    // 执行长测例时也要让协调者知道本机仍然存活
+    heartbeat_thread_ = std::thread([this] {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while(!stop_cv_.wait_for(lock, std::chrono::milliseconds(heartbeat_ms_), [this] { return stop_; })) {
+            conn_.SendAll("PING\n");
+        }
+    });
+
+    bool graceful = false;
+    std::string line;
+    while(conn_.ReadLine(line)) {
+        if(line == "BYE") {
+            graceful = true;
+            break;
+        }
+        if(line.rfind("REVOKE ", 0) == 0) {
+            std::vector<std::string> tests;
+            int batch_id = ParseBatch(line.substr(7), tests);
+            Revoke(batch_id, tests);
+            continue;
+        }
+        if(line.rfind("BATCH ", 0) != 0) continue;
+
+        std::vector<std::string> tests;
+        int batch_id = ParseBatch(line.substr(6), tests);
+        if(tests.empty()) {
+            Send("DONE " + std::to_string(batch_id) + "\nPULL\n");
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            for(auto const& test: tests) owner_[test] = batch_id;
+            pending_[batch_id] = tests.size();
+        }
+        executor_.SubmitTestBatch(tests);
+    }
+
+    // 协调者丢失时终止本机子进程，未完成的测例由协调者重新分配
+    if(!graceful) executor_.Cancel();
+    executor_.WaitIdle();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    stop_cv_.notify_all();
+    heartbeat_thread_.join();
+    conn_.Close();
+    return graceful;
+}
+
+/**
+ * @brief 单个测例结果回调，转发给协调者
+ *
+ * @param result
+ */
+void Agent::OnResult(TestResult const& result) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = owner_.find(result.name);
+    if(it == owner_.end()) return;
+    int batch_id = it->second;
+    owner_.erase(it);
+
+    std::string msg = "RESULT " + std::to_string(batch_id) + "\t" + result.name + "\t" + result.status + "\t" + std::to_string(result.duration_ms) + "\n";
+    if(--pending_[batch_id] == 0) {
+        pending_.erase(batch_id);
+        msg += "DONE " + std::to_string(batch_id) + "\nPULL\n";
+    }
+    conn_.SendAll(msg);
+}
+
+/**
+ * @brief 撤回批次中尚未开始执行的测例并告知协调者
+ *
+ * @param batch_id
+ * @param tests
+ */
+void Agent::Revoke(int batch_id, std::vector<std::string> const& tests) {
+    // 已有结果的测例不在 owner_ 中；执行器在结果回调前将测例记为已开始，回调阻塞在 mtx_ 上的测例不会被撤回
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<std::string> candidates;
+    for(auto const& test: tests) {
+        auto it = owner_.find(test);
+        if(it != owner_.end() && it->second == batch_id) candidates.push_back(test);
+    }
+
+    std::string msg = "REVOKED " + std::to_string(batch_id);
+    std::vector<std::string> revoked = candidates.empty() ? candidates : executor_.Revoke(candidates);
+    for(auto const& test: revoked) {
+        owner_.erase(test);
+        msg += "\t" + test;
+    }
+    msg += "\n";
+    auto pending = pending_.find(batch_id);
+    if(!revoked.empty() && pending != pending_.end() && (pending->second -= revoked.size()) == 0) {
+        pending_.erase(pending);
+        msg += "DONE " + std::to_string(batch_id) + "\nPULL\n";
+    }
+    conn_.SendAll(msg);
+}
+
+/**
+ * @brief 向协调者发送数据
+ *
+ * @param msg
+ */
+void Agent::Send(std::string const& msg) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    conn_.SendAll(msg);
+}
@@ -0,0 +1,163 @@
+#include "BenchDaemon.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "FileWatcher.h"
+
+namespace {
+    constexpr int kClientSendTimeoutMs = 1000;  // 客户端超过该时间不读取即断开
+    constexpr size_t kMaxQueuedLines = 65536;   // 推送队列上限
+}  // namespace
+
+/**
+ * @brief Construct a new Bench Daemon object
+ *
+ * @param config
+ * @param socket_path
+ * @param thread_num
+ */
+BenchDaemon::BenchDaemon(RunConfig const& config, std::string const& socket_path, int thread_num):
+    config_(config), preprocess_(config.gtest_filter, config.exe_path, (config.out_dir / "test_name.txt").string()), runner_(thread_num), listener_(Socket::ListenLocal(socket_path)) {
+    config_.on_result = [this](TestResult const& result) { OnResult(result); };
+    accept_thread_ = std::thread([this] { AcceptClients(); });
+    sender_thread_ = std::thread([this] { SendLines(); });
+}
+
+BenchDaemon::~BenchDaemon() {
+    listener_.Shutdown();
+    accept_thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(outbox_mtx_);
+        stopping_ = true;
+    }
+    outbox_cv_.notify_one();
+    sender_thread_.join();
+}
+
+/**
+ * @brief 运行一轮后持续监视测试程序
+ *
+ */
+void BenchDaemon::Run() {
+    FileWatcher watcher({config_.exe_path});
+    while(true) {
+        // 单轮失败 (如测试程序正在重新生成) 不结束常驻进程，等待下一次变化
+        try {
+            RunOnce();
+        } catch(std::exception const& e) {
+            std::string message = e.what();
+            std::replace(message.begin(), message.end(), '\n', ' ');
+            std::cerr << "Run failed: " << message << "\n";
+            Broadcast("RUN_ERROR " + message + "\n", true);
+        }
+        std::cout << "\nWaiting for " << config_.exe_path << " to change...\n";
+        watcher.WaitForChange();
+    }
+}
+
+/**
+ * @brief 重新获取测例并完整运行一轮
+ *
+ */
+void BenchDaemon::RunOnce() {
+    // 测试程序重新生成后测例可能增删，只需一次 --gtest_list_tests
+    preprocess_.GetTests();
+    std::vector<std::string> test_names = preprocess_.ReadTests();
+
+    // 上一轮失败的测例最先提交，其余按历史耗时从长到短，新增测例视为最长
+    std::vector<std::string> rest;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        config_.test_names.clear();
+        for(auto const& name: test_names) (failing_.count(name) ? config_.test_names : rest).push_back(name);
+        std::stable_sort(rest.begin(), rest.end(), [this](std::string const& a, std::string const& b) {
+            auto ia = durations_ms_.find(a);
+            auto ib = durations_ms_.find(b);
+            if(ib == durations_ms_.end()) return false;
+            if(ia == durations_ms_.end()) return true;
+            return ia->second > ib->second;
+        });
+        config_.test_names.insert(config_.test_names.end(), rest.begin(), rest.end());
+        failing_.clear();
+    }
+
+    Broadcast("RUN_START " + std::to_string(test_names.size()) + "\n", true);
+    if(test_names.empty()) {
+        Broadcast("RUN_END 0 0 0\n", true);
+        return;
+    }
+
+    // 结果文件以追加方式打开，每轮开始前将上一轮的结果轮换为 result.prev.txt，文件只包含本轮结果
+    std::error_code ec;
+    std::filesystem::rename(config_.out_dir / "result.txt", config_.out_dir / "result.prev.txt", ec);
+
+    RunSummary summary = runner_.Start(config_).Wait();
+    size_t failed = summary.failed + summary.timed_out + summary.interrupted;
+    Broadcast("RUN_END " + std::to_string(summary.passed) + " " + std::to_string(failed) + " " + std::to_string(summary.seconds) + "\n", true);
+    std::cout << "\nRun completed: " << summary.passed << "/" << summary.total << " passed, " << summary.seconds << "s\n";
+}
+
+/**
+ * @brief 单个测例结果回调
+ *
+ * @param result
+ */
+void BenchDaemon::OnResult(TestResult const& result) {
+    Broadcast(result.name + "\t" + result.status + "\t" + std::to_string(result.duration_ms) + "\n");
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if(result.status != "Passed" && result.status != "Skipped") failing_.insert(result.name);
+    if(result.duration_ms > 0) durations_ms_[result.name] = result.duration_ms;
+}
+
+/**
+ * @brief 接受客户端连接的线程函数
+ *
+ */
+void BenchDaemon::AcceptClients() {
+    while(true) {
+        Socket client = listener_.Accept();
+        if(!client.Valid()) return;
+        client.SetSendTimeout(kClientSendTimeoutMs);
+        std::lock_guard<std::mutex> lock(clients_mtx_);
+        clients_.push_back(std::move(client));
+    }
+}
+
+/**
+ * @brief 将一行放入推送队列
+ *
+ * @param line
+ * @param control
+ */
+void BenchDaemon::Broadcast(std::string const& line, bool control) {
+    {
+        std::lock_guard<std::mutex> lock(outbox_mtx_);
+        // 控制行数量有限，始终保留，客户端才能知道一轮运行何时结束
+        if(!control && outbox_.size() >= kMaxQueuedLines) return;
+        outbox_.push_back(line);
+    }
+    outbox_cv_.notify_one();
+}
+
+/**
+ * @brief 推送线程函数，每次取出队列中全部行合并发送
+ *
+ */
+void BenchDaemon::SendLines() {
+    std::unique_lock<std::mutex> lock(outbox_mtx_);
+    while(true) {
+        outbox_cv_.wait(lock, [this] { return stopping_ || !outbox_.empty(); });
+        if(outbox_.empty()) return;
+        std::string data;
+        for(auto const& line: outbox_) data += line;
+        outbox_.clear();
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> clients_lock(clients_mtx_);
+            clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [&data](Socket& client) { return !client.SendAll(data); }), clients_.end());
+        }
+        lock.lock();
+    }
+}
@@ -11,11 +11,37 @@ ConcurrentResultWriter::ConcurrentResultWriter(std::string const& file_name): ou
 }
 
 void ConcurrentResultWriter::AddResult(ExecuteResult const& result) {
+    std::function<void(TestResult const&)> listener;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for(auto const& res: result.complete_tests) outfile_ << res.first << " : " << res.second << "\n";
+        for(auto const& res: result.skipped_tests) outfile_ << res << " : Skipped\n";
+        for(auto const& res: result.timed_out_tests) outfile_ << res << " : Timed_out\n";
+        for(auto const& res: result.interrupted_tests) outfile_ << res << " : Interrupted\n";
+        for(auto const& res: result.cancelled_tests) outfile_ << res << " : Cancelled\n";
+        listener = listener_;
+    }
+    if(!listener) return;
+
+    // 回调在锁外触发，避免慢速的监听者阻塞其他线程写入
+    for(auto const& res: result.complete_tests) {
+        auto it = result.durations_ms.find(res.first);
+        listener({res.first, res.second, "", it == result.durations_ms.end() ? 0 : it->second});
+    }
+    for(auto const& res: result.skipped_tests) listener({res, "Skipped", ""});
+    for(auto const& res: result.timed_out_tests) listener({res, "Timed_out", ""});
+    for(auto const& res: result.interrupted_tests) listener({res, "Interrupted", ""});
+    for(auto const& res: result.cancelled_tests) listener({res, "Cancelled", ""});
+}
+
+/**
+ * @brief 设置逐测例结果回调
+ *
+ * @param listener
+ */
+void ConcurrentResultWriter::SetListener(std::function<void(TestResult const&)> listener) {
     std::lock_guard<std::mutex> lock(mtx_);
-    for(auto const& res: result.complete_tests) outfile_ << res.first << " : " << res.second << "\n";
-    for(auto const& res: result.skipped_tests) outfile_ << res << " : Skipped\n";
-    for(auto const& res: result.timed_out_tests) outfile_ << res << " : Timed_out\n";
-    for(auto const& res: result.interrupted_tests) outfile_ << res << " : Interrupted\n";
+    listener_ = std::move(listener);
 }
 
 void ConcurrentResultWriter::AddResult(std::string const& result) {
@@ -0,0 +1,326 @@
+#include "Coordinator.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "TestExecutor.h"
+#include "TestPreprocess.h"
+
+namespace {
+    constexpr int kAgentSendTimeoutMs = 5000;  // Agent 超过该时间不读取即视为丢失
+
+    /**
+     * @brief 按制表符切分一行
+     */
+    std::vector<std::string> SplitTabs(std::string const& line) {
+        std::vector<std::string> fields;
+        std::istringstream iss(line);
+        std::string field;
+        while(std::getline(iss, field, '\t')) fields.push_back(field);
+        return fields;
+    }
+
+    /**
+     * @brief 补全输出目录
+     */
+    RunConfig ResolveOutDir(RunConfig config) {
+        if(config.out_dir.empty()) config.out_dir = std::filesystem::path(config.exe_path).parent_path() / "output";
+        std::filesystem::create_directories(config.out_dir);
+        return config;
+    }
+}  // namespace
+
+/**
+ * @brief Construct a new Coordinator object
+ *
+ * @param config
+ * @param port
+ * @param agent_timeout_ms
+ */
+Coordinator::Coordinator(RunConfig const& config, int port, int agent_timeout_ms):
+    config_(ResolveOutDir(config)), agent_timeout_ms_(agent_timeout_ms), writer_((config_.out_dir / "result.txt").string()), listener_(Socket::ListenTcp(port)) {
+    writer_.total_ = 0;
+    writer_.completed_ = 0;
+    writer_.SetListener([this](TestResult const& result) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            summary_.Record(result.status);
+        }
+        if(config_.on_result) config_.on_result(result);
+    });
+}
+
+Coordinator::~Coordinator() {
+    listener_.Shutdown();
+    if(accept_thread_.joinable()) accept_thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for(auto& agent: agents_) agent->socket.Shutdown();
+    }
+    for(auto& t: agent_threads_) t.join();
+}
+
+/**
+ * @brief 获取测例并等待 Agent 执行完毕
+ *
+ * @return RunSummary
+ */
+RunSummary Coordinator::Run() {
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::string> test_names = config_.test_names;
+    if(test_names.empty()) {
+        TestPreprocess tp(config_.gtest_filter, config_.exe_path, (config_.out_dir / "test_name.txt").string());
+        tp.GetTests();
+        test_names = tp.ReadTests();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        queue_.assign(test_names.begin(), test_names.end());
+        total_ = test_names.size();
+        summary_.total = total_;
+        finished_ = total_ == 0;
+    }
+    writer_.total_ = static_cast<int>(test_names.size());
+    accept_thread_ = std::thread([this] { AcceptAgents(); });
+
+    RunSummary summary;
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        done_cv_.wait(lock, [this] { return finished_; });
+
+        // 全部完成，通知仍在等待批次的 Agent 退出
+        for(auto& agent: agents_) SendLocked(*agent, "BYE\n");
+        summary_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        summary = summary_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(writer_.mtx_);
+        writer_.outfile_.flush();
+    }
+    if(config_.on_complete) config_.on_complete(summary);
+    return summary;
+}
+
+/**
+ * @brief 接受 Agent 连接的线程函数
+ *
+ */
+void Coordinator::AcceptAgents() {
+    while(true) {
+        Socket conn = listener_.Accept();
+        if(!conn.Valid()) return;
+        conn.SetRecvTimeout(agent_timeout_ms_);
+        // 发送在持有 mtx_ 时进行，停止读取的 Agent 不能阻塞调度与其他 Agent 的超时清理
+        conn.SetSendTimeout(kAgentSendTimeoutMs);
+
+        auto agent = std::make_shared<AgentConn>();
+        agent->socket = std::move(conn);
+        std::lock_guard<std::mutex> lock(mtx_);
+        if(finished_) {
+            agent->socket.SendAll("BYE\n");
+            continue;
+        }
+        agents_.push_back(agent);
+        agent_threads_.emplace_back([this, agent] { ServeAgent(agent); });
+    }
+}
+
+/**
+ * @brief 处理单个 Agent 消息的线程函数
+ *
+ * @param agent
+ */
+void Coordinator::ServeAgent(std::shared_ptr<AgentConn> agent) {
+    std::string line;
+    while(agent->socket.ReadLine(line)) {
+        std::string command = line.substr(0, line.find(' '));
+        std::string args = line.size() > command.size() ? line.substr(command.size() + 1) : "";
+
+        if(command == "RESULT") {
+            HandleResult(*agent, SplitTabs(args));
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        if(command == "HELLO") {
+            total_slots_ -= agent->slots;
+            agent->slots = std::max(1, std::atoi(args.c_str()));
+            total_slots_ += agent->slots;
+        } else if(command == "PULL") {
+            agent->pending_pulls++;
+            DispatchLocked();
+        } else if(command == "DONE") {
+            // 正常情况下批次内测例均已有结果，残留的视为丢失并重新入队
+            auto it = agent->in_flight.find(std::atoi(args.c_str()));
+            if(it != agent->in_flight.end()) {
+                queue_.insert(queue_.begin(), it->second.tests.begin(), it->second.tests.end());
+                agent->in_flight.erase(it);
+                DispatchLocked();
+            }
+        } else if(command == "REVOKED") {
+            HandleRevokedLocked(*agent, SplitTabs(args));
+        }
+        // PING 只用于刷新接收超时
+    }
+
+    // Agent 断开或心跳超时，未完成的测例放回队首优先重新下发
+    std::lock_guard<std::mutex> lock(mtx_);
+    size_t requeued = 0;
+    for(auto const& [batch_id, batch]: agent->in_flight) {
+        queue_.insert(queue_.begin(), batch.tests.begin(), batch.tests.end());
+        requeued += batch.tests.size();
+    }
+    agent->in_flight.clear();
+    total_slots_ -= agent->slots;
+    agents_.remove(agent);
+    agent->socket.Shutdown();
+    if(requeued && !finished_) {
+        std::cout << "\nAgent lost, requeued " << requeued << " tests\n";
+        DispatchLocked();
+    }
+}
+
+/**
+ * @brief 记录一条测例结果
+ *
+ * @param agent
+ * @param fields
+ */
+void Coordinator::HandleResult(AgentConn& agent, std::vector<std::string> const& fields) {
+    if(fields.size() < 4) return;
+    int batch_id = std::atoi(fields[0].c_str());
+    std::string const& name = fields[1];
+    std::string const& status = fields[2];
+    {
+        // 只接受确实下发给该 Agent 的测例，防止重复计数
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto batch = agent.in_flight.find(batch_id);
+        if(batch == agent.in_flight.end()) return;
+        auto& tests = batch->second.tests;
+        auto it = std::find(tests.begin(), tests.end(), name);
+        if(it == tests.end()) return;
+        tests.erase(it);
+    }
+
+    ExecuteResult result{};
+    if(status == "Passed" || status == "Failed")
+        result.complete_tests.push_back({name, status});
+    else if(status == "Skipped")
+        result.skipped_tests.push_back(name);
+    else if(status == "Timed_out")
+        result.timed_out_tests.push_back(name);
+    else if(status == "Cancelled")
+        result.cancelled_tests.push_back(name);
+    else
+        result.interrupted_tests.push_back(name);
+    result.durations_ms[name] = std::atoll(fields[3].c_str());
+    writer_.completed_++;
+    writer_.AddResult(result);
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if(++completed_ >= total_) {
+        finished_ = true;
+        done_cv_.notify_all();
+    }
+}
+
+/**
+ * @brief 为挂起的 PULL 分配批次
+ *
+ */
+void Coordinator::DispatchLocked() {
+    for(auto& agent: agents_) {
+        // 发送失败的 Agent 已断开，清理前仍可能读到其 PULL，不再下发
+        while(!agent->lost && agent->pending_pulls > 0 && !queue_.empty()) {
+            // 批次随剩余测例减少而缩小，开始时摊薄进程创建开销，结束时各槽位负载均衡
+            size_t size = std::max<size_t>(1, queue_.size() / (2 * static_cast<size_t>(std::max(1, total_slots_))));
+            if(config_.batch_size) size = std::min(size, config_.batch_size);
+            size = std::min(size, queue_.size());
+
+            int batch_id = next_batch_id_++;
+            std::vector<std::string> tests(queue_.begin(), queue_.begin() + size);
+            queue_.erase(queue_.begin(), queue_.begin() + size);
+
+            std::string msg = "BATCH " + std::to_string(batch_id);
+            for(auto const& test: tests) msg += "\t" + test;
+            agent->in_flight[batch_id].tests = std::move(tests);
+            agent->pending_pulls--;
+            // 发送失败时由该 Agent 的线程在读取出错后重新入队
+            SendLocked(*agent, msg + "\n");
+        }
+    }
+    if(queue_.empty()) StealLocked();
+}
+
+/**
+ * @brief 队列为空时向未完成测例最多的批次请求撤回后一半测例
+ *
+ */
+void Coordinator::StealLocked() {
+    bool idle = std::any_of(agents_.begin(), agents_.end(), [](auto const& agent) { return !agent->lost && agent->pending_pulls > 0; });
+    if(!idle) return;
+
+    AgentConn* victim = nullptr;
+    int victim_id = 0;
+    size_t most = 1;
+    for(auto& agent: agents_) {
+        for(auto const& [batch_id, batch]: agent->in_flight) {
+            if(!agent->lost && batch.stealable && !batch.revoking && batch.tests.size() > most) {
+                victim = agent.get();
+                victim_id = batch_id;
+                most = batch.tests.size();
+            }
+        }
+    }
+    if(!victim) return;
+
+    // 批次按 gtest 的定义顺序执行，后一半最可能尚未开始，第一个测例可能正在执行，始终保留
+    Batch& batch = victim->in_flight[victim_id];
+    batch.revoking = true;
+    std::string msg = "REVOKE " + std::to_string(victim_id);
+    for(size_t i = (batch.tests.size() + 1) / 2; i < batch.tests.size(); i++) msg += "\t" + batch.tests[i];
+    SendLocked(*victim, msg + "\n");
+}
+
+/**
+ * @brief 向 Agent 发送消息，失败时断开连接
+ *
+ * @param agent
+ * @param msg
+ * @return true
+ * @return false
+ */
+bool Coordinator::SendLocked(AgentConn& agent, std::string const& msg) {
+    if(agent.lost) return false;
+    if(agent.socket.SendAll(msg)) return true;
+
+    // 发送超时或出错后连接中的数据已不完整，断开后由该 Agent 的线程在读取出错时将未完成的测例重新入队
+    agent.lost = true;
+    agent.socket.Shutdown();
+    return false;
+}
+
+/**
+ * @brief 将 Agent 撤回的测例放回队首
+ *
+ * @param agent
+ * @param fields
+ */
+void Coordinator::HandleRevokedLocked(AgentConn& agent, std::vector<std::string> const& fields) {
+    if(fields.empty()) return;
+    auto it = agent.in_flight.find(std::atoi(fields[0].c_str()));
+    if(it == agent.in_flight.end()) return;
+
+    Batch& batch = it->second;
+    batch.revoking = false;
+    // 一个都没有撤回说明后一半已经开始执行，该批次不再尝试，避免反复请求
+    if(fields.size() == 1) batch.stealable = false;
+    for(size_t i = fields.size() - 1; i >= 1; i--) {
+        auto test = std::find(batch.tests.begin(), batch.tests.end(), fields[i]);
+        if(test == batch.tests.end()) continue;
+        batch.tests.erase(test);
+        queue_.push_front(fields[i]);
+    }
+    DispatchLocked();
+}
@@ -0,0 +1,142 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <poll.h>
+#    include <sys/inotify.h>
+#    include <unistd.h>
+#endif
+
+namespace {
+    /**
+     * @brief 被监视文件所在的目录，去重
+     */
+    std::set<std::filesystem::path> ParentDirs(std::vector<std::filesystem::path> const& files) {
+        std::set<std::filesystem::path> dirs;
+        for(auto const& file: files) dirs.insert(file.parent_path());
+        return dirs;
+    }
+}  // namespace
+
+#ifdef _WIN32
+
+/**
+ * @brief Construct a new File Watcher object
+ *
+ * @param files
+ */
+FileWatcher::FileWatcher(std::vector<std::filesystem::path> const& files) {
+    for(auto const& file: files) files_.push_back(std::filesystem::absolute(file));
+    for(auto const& dir: ParentDirs(files_)) {
+        HANDLE handle = FindFirstChangeNotificationA(dir.string().c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+        if(handle == INVALID_HANDLE_VALUE) throw std::runtime_error("FindFirstChangeNotification failed: " + dir.string());
+        handles_.push_back(handle);
+    }
+    for(auto const& file: files_) {
+        std::error_code ec;
+        write_times_.push_back(std::filesystem::last_write_time(file, ec));
+    }
+}
+
+FileWatcher::~FileWatcher() {
+    for(auto handle: handles_) FindCloseChangeNotification(handle);
+}
+
+bool FileWatcher::WaitEvent(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while(true) {
+        DWORD wait_ms = INFINITE;
+        if(timeout.count() >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            wait_ms = static_cast<DWORD>(std::max<long long>(left, 0));
+        }
+        DWORD ret = WaitForMultipleObjects(static_cast<DWORD>(handles_.size()), handles_.data(), FALSE, wait_ms);
+        if(ret == WAIT_TIMEOUT) return false;
+        if(ret >= WAIT_OBJECT_0 + handles_.size()) throw std::runtime_error("WaitForMultipleObjects failed");
+        FindNextChangeNotification(handles_[ret - WAIT_OBJECT_0]);
+
+        // 目录中其他文件的变化同样会触发通知，只关心被监视文件
+        bool changed = false;
+        for(size_t i = 0; i < files_.size(); i++) {
+            std::error_code ec;
+            auto write_time = std::filesystem::last_write_time(files_[i], ec);
+            if(write_time != write_times_[i]) {
+                write_times_[i] = write_time;
+                changed = true;
+            }
+        }
+        if(changed) return true;
+    }
+}
+
+#else
+
+/**
+ * @brief Construct a new File Watcher object
+ *
+ * @param files
+ */
+FileWatcher::FileWatcher(std::vector<std::filesystem::path> const& files): inotify_fd_(inotify_init1(IN_CLOEXEC)) {
+    if(inotify_fd_ < 0) throw std::runtime_error("inotify_init1 failed");
+    for(auto const& file: files) files_.push_back(std::filesystem::absolute(file));
+    for(auto const& dir: ParentDirs(files_)) {
+        // 链接器可能原地写入，也可能写临时文件后重命名
+        if(inotify_add_watch(inotify_fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            close(inotify_fd_);
+            throw std::runtime_error("inotify_add_watch failed: " + dir.string());
+        }
+    }
+}
+
+FileWatcher::~FileWatcher() {
+    close(inotify_fd_);
+}
+
+bool FileWatcher::WaitEvent(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    alignas(inotify_event) char buffer[4096];
+    while(true) {
+        int wait_ms = -1;
+        if(timeout.count() >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            wait_ms = static_cast<int>(std::max<long long>(left, 0));
+        }
+        pollfd pfd{inotify_fd_, POLLIN, 0};
+        int ret = poll(&pfd, 1, wait_ms);
+        if(ret == 0) return false;
+        if(ret < 0) throw std::runtime_error("poll on inotify failed");
+
+        ssize_t len = read(inotify_fd_, buffer, sizeof(buffer));
+        if(len <= 0) throw std::runtime_error("read on inotify failed");
+
+        // 目录中其他文件的变化同样会触发事件，只关心被监视文件
+        bool changed = false;
+        for(char* p = buffer; p < buffer + len;) {
+            auto const* event = reinterpret_cast<inotify_event const*>(p);
+            if(event->len > 0) {
+                std::string name(event->name);
+                changed = changed || std::any_of(files_.begin(), files_.end(), [&name](auto const& file) { return file.filename() == name; });
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+        if(changed) return true;
+    }
+}
+
+#endif
+
+/**
+ * @brief 阻塞等待任一被监视文件发生变化
+ *
+ * @param settle
+ */
+void FileWatcher::WaitForChange(std::chrono::milliseconds settle) {
+    WaitEvent(std::chrono::milliseconds(-1));
+    while(WaitEvent(settle)) {
+    }
+}
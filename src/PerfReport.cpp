@@ -0,0 +1,176 @@
+#include "PerfReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    /**
+     * @brief 已排序样本的分位数，线性插值
+     */
+    double Quantile(std::vector<double> const& sorted, double q) {
+        if(sorted.empty()) return 0;
+        double pos = q * static_cast<double>(sorted.size() - 1);
+        size_t lo = static_cast<size_t>(std::floor(pos));
+        size_t hi = std::min(lo + 1, sorted.size() - 1);
+        return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - static_cast<double>(lo));
+    }
+}  // namespace
+
+/**
+ * @brief 记录一个耗时样本
+ *
+ * @param name
+ * @param duration_ms
+ */
+void PerfReport::AddSample(std::string const& name, double duration_ms) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    samples_[name].push_back(duration_ms);
+}
+
+/**
+ * @brief 读取基线报告，只使用测例名与原始样本两列
+ *
+ * @param path
+ */
+void PerfReport::LoadBaseline(std::filesystem::path const& path) {
+    std::ifstream infile(path);
+    if(!infile.is_open()) throw std::runtime_error("Cannot open baseline file: " + path.string());
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::string line;
+    while(std::getline(infile, line)) {
+        if(line.empty() || line[0] == '#') continue;
+        size_t name_end = line.find('\t');
+        size_t samples_begin = line.rfind('\t');
+        if(name_end == std::string::npos) continue;
+
+        std::vector<double>& samples = baseline_[line.substr(0, name_end)];
+        std::istringstream iss(line.substr(samples_begin + 1));
+        std::string value;
+        while(std::getline(iss, value, ',')) {
+            if(!value.empty()) samples.push_back(std::stod(value));
+        }
+    }
+}
+
+/**
+ * @brief 基线样本数少于 kMinSamples 的测例数
+ *
+ * @return size_t
+ */
+size_t PerfReport::CountUnderSampledBaselines() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return std::count_if(baseline_.begin(), baseline_.end(), [](auto const& kv) { return kv.second.size() < kMinSamples; });
+}
+
+/**
+ * @brief 计算统计量并与基线比较
+ *
+ * @param alpha
+ * @param threshold
+ * @return std::vector<DurationStats>
+ */
+std::vector<DurationStats> PerfReport::Analyze(double alpha, double threshold) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<DurationStats> result;
+    for(auto const& [name, samples]: samples_) {
+        DurationStats stats;
+        stats.name = name;
+        stats.samples_ms = samples;
+
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        double n = static_cast<double>(sorted.size());
+        stats.mean_ms = std::accumulate(sorted.begin(), sorted.end(), 0.0) / n;
+        stats.median_ms = Quantile(sorted, 0.5);
+        stats.p95_ms = Quantile(sorted, 0.95);
+        if(sorted.size() > 1) {
+            double ss = 0;
+            for(double x: sorted) ss += (x - stats.mean_ms) * (x - stats.mean_ms);
+            stats.variance = ss / (n - 1);
+        }
+
+        auto it = baseline_.find(name);
+        if(it != baseline_.end() && !it->second.empty()) {
+            std::vector<double> baseline_sorted = it->second;
+            std::sort(baseline_sorted.begin(), baseline_sorted.end());
+            stats.has_baseline = true;
+            stats.baseline_median_ms = Quantile(baseline_sorted, 0.5);
+            stats.p_value = MannWhitneyGreater(samples, it->second);
+            stats.regressed = stats.p_value < alpha && stats.median_ms > stats.baseline_median_ms * (1 + threshold);
+        }
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+/**
+ * @brief 写出报告
+ *
+ * @param path
+ * @param stats
+ */
+void PerfReport::Write(std::filesystem::path const& path, std::vector<DurationStats> const& stats) {
+    std::ofstream outfile(path);
+    if(!outfile.is_open()) throw std::runtime_error("Cannot open report file: " + path.string());
+
+    outfile << "# name\tn\tmean_ms\tmedian_ms\tp95_ms\tvariance\tbaseline_median_ms\tp_value\tregressed\tsamples_ms\n";
+    for(auto const& s: stats) {
+        outfile << s.name << "\t" << s.samples_ms.size() << "\t" << s.mean_ms << "\t" << s.median_ms << "\t" << s.p95_ms << "\t" << s.variance << "\t";
+        if(s.has_baseline)
+            outfile << s.baseline_median_ms << "\t" << s.p_value << "\t" << (s.regressed ? "yes" : "no") << "\t";
+        else
+            outfile << "-\t-\t-\t";
+        for(size_t i = 0; i < s.samples_ms.size(); i++) outfile << (i ? "," : "") << s.samples_ms[i];
+        outfile << "\n";
+    }
+}
+
+/**
+ * @brief 单侧 Mann-Whitney U 检验
+ *
+ * 对耗时这类偏态、常有离群值的分布比 t 检验稳健。使用带结修正与连续性修正的正态近似，
+ * 两侧样本数均不少于 5 时足够准确；样本过少时返回 1，即不判定回退。
+ *
+ * @param current
+ * @param baseline
+ * @return double
+ */
+double PerfReport::MannWhitneyGreater(std::vector<double> const& current, std::vector<double> const& baseline) {
+    size_t n1 = current.size();
+    size_t n2 = baseline.size();
+    if(n1 < kMinSamples || n2 < kMinSamples) return 1;
+
+    // 合并排序后计算秩，相同值取平均秩
+    std::vector<std::pair<double, bool>> all;  // 值, 是否来自 current
+    for(double x: current) all.push_back({x, true});
+    for(double x: baseline) all.push_back({x, false});
+    std::sort(all.begin(), all.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+
+    double rank_sum = 0;
+    double tie_term = 0;
+    for(size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while(j < all.size() && all[j].first == all[i].first) j++;
+        double avg_rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2;
+        for(size_t k = i; k < j; k++) {
+            if(all[k].second) rank_sum += avg_rank;
+        }
+        double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    double N = static_cast<double>(n1 + n2);
+    double u = rank_sum - static_cast<double>(n1) * static_cast<double>(n1 + 1) / 2;
+    double mean_u = static_cast<double>(n1) * static_cast<double>(n2) / 2;
+    double var_u = static_cast<double>(n1) * static_cast<double>(n2) / 12 * ((N + 1) - tie_term / (N * (N - 1)));
+    if(var_u <= 0) return 1;
+
+    double z = (u - mean_u - 0.5) / std::sqrt(var_u);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
@@ -0,0 +1,156 @@
+#include "SlotSandbox.h"
+
+#include <atomic>
+#include <stdexcept>
+
+#ifdef _WIN32
+#    include <Windows.h>
+#    include <process.h>
+#    define GETPID _getpid
+#else
+#    include <fcntl.h>
+#    include <sys/file.h>
+#    include <unistd.h>
+#    define GETPID getpid
+#endif
+
+namespace {
+    constexpr int kMaxPort = 65535;
+    constexpr std::intptr_t kNoLock = -1;
+
+    /**
+     * @brief 以独占方式打开锁文件，文件已被其他句柄锁定时返回 kNoLock
+     */
+    std::intptr_t TryLockFile(std::filesystem::path const& path) {
+#ifdef _WIN32
+        // 不共享任何访问权限，其他句柄打开时失败于 ERROR_SHARING_VIOLATION
+        HANDLE handle = CreateFileA(path.string().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return handle == INVALID_HANDLE_VALUE ? kNoLock : reinterpret_cast<std::intptr_t>(handle);
+#else
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+        if(fd < 0) return kNoLock;
+        // flock 属于打开的文件描述，同一进程内的另一次 open 同样会冲突
+        if(flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            close(fd);
+            return kNoLock;
+        }
+        return fd;
+#endif
+    }
+
+    /**
+     * @brief 关闭锁文件，释放端口段
+     */
+    void UnlockFile(std::intptr_t lock) {
+        if(lock == kNoLock) return;
+#ifdef _WIN32
+        CloseHandle(reinterpret_cast<HANDLE>(lock));
+#else
+        close(static_cast<int>(lock));
+#endif
+    }
+}  // namespace
+
+/**
+ * @brief Construct a new Slot Sandbox object
+ *
+ * @param config
+ * @param slot_count
+ */
+SlotSandbox::SlotSandbox(SandboxConfig const& config, int slot_count): config_(config), slot_count_(slot_count), port_base_(0), port_lock_(kNoLock) {
+    ReservePorts();
+
+    std::filesystem::path base = config_.root;
+    if(base.empty()) base = std::filesystem::temp_directory_path() / "ConcurBench";
+    // 同一台机器上可能同时运行多个进程，同一进程中也可能同时存在多次运行，各自只清理自己的根目录
+    static std::atomic<int> instance_seq{0};
+    root_ = base / ("sandbox_" + std::to_string(GETPID()) + "_" + std::to_string(instance_seq++));
+    try {
+        std::filesystem::create_directories(root_);
+    } catch(...) {
+        UnlockFile(port_lock_);
+        throw;
+    }
+}
+
+SlotSandbox::~SlotSandbox() {
+    UnlockFile(port_lock_);
+    if(config_.cleanup == SandboxCleanup::kNever) return;
+    std::error_code ec;
+    std::filesystem::remove_all(root_, ec);
+}
+
+/**
+ * @brief 依次尝试锁定端口段
+ *
+ */
+void SlotSandbox::ReservePorts() {
+    if(slot_count_ <= 0 || config_.port_base <= 0 || config_.ports_per_slot <= 0) throw std::runtime_error("Invalid sandbox port range");
+    long long span = static_cast<long long>(slot_count_) * config_.ports_per_slot;
+    if(config_.port_base + span - 1 > kMaxPort) {
+        throw std::runtime_error("Sandbox ports exceed " + std::to_string(kMaxPort) + ": port_base " + std::to_string(config_.port_base) + " + " + std::to_string(slot_count_) + " slots * " + std::to_string(config_.ports_per_slot) + " ports");
+    }
+
+    std::filesystem::path lock_dir = std::filesystem::temp_directory_path() / "ConcurBench" / "ports";
+    std::filesystem::create_directories(lock_dir);
+    for(long long base = config_.port_base; base + span - 1 <= kMaxPort; base += span) {
+        std::intptr_t lock = TryLockFile(lock_dir / (std::to_string(base) + ".lock"));
+        if(lock == kNoLock) continue;
+        port_base_ = static_cast<int>(base);
+        port_lock_ = lock;
+        return;
+    }
+    throw std::runtime_error("No free sandbox port range from " + std::to_string(config_.port_base));
+}
+
+/**
+ * @brief 准备槽位目录并生成子进程需要覆盖的环境变量
+ *
+ * @param slot
+ * @return EnvList
+ */
+EnvList SlotSandbox::Prepare(int slot) {
+    if(slot < 0 || slot >= slot_count_) throw std::out_of_range("Sandbox slot out of range: " + std::to_string(slot));
+    std::filesystem::path dir = SlotDir(slot);
+    std::filesystem::path tmp_dir = dir / "tmp";
+    std::filesystem::path home_dir = dir / "home";
+    std::filesystem::create_directories(tmp_dir);
+    std::filesystem::create_directories(home_dir);
+
+    int port_base = port_base_ + slot * config_.ports_per_slot;
+    return {
+      {"TMPDIR",                 tmp_dir.string()                      },
+      {"TMP",                    tmp_dir.string()                      },
+      {"TEMP",                   tmp_dir.string()                      },
+      {"HOME",                   home_dir.string()                     },
+      {"USERPROFILE",            home_dir.string()                     },
+      {"CONCURBENCH_SLOT",       std::to_string(slot)                  },
+      {"CONCURBENCH_SCRATCH",    dir.string()                          },
+      {"CONCURBENCH_PORT_BASE",  std::to_string(port_base)             },
+      {"CONCURBENCH_PORT_COUNT", std::to_string(config_.ports_per_slot)},
+    };
+}
+
+/**
+ * @brief 一组测例结束，按清理策略处理槽位目录
+ *
+ * @param slot
+ */
+void SlotSandbox::Release(int slot) {
+    if(config_.cleanup != SandboxCleanup::kPerBatch) return;
+    // 被终止的子进程可能仍占用文件，清理失败时留给下一组复用
+    std::error_code ec;
+    std::filesystem::remove_all(SlotDir(slot), ec);
+}
+
+std::filesystem::path SlotSandbox::SlotDir(int slot) const {
+    return root_ / ("slot_" + std::to_string(slot));
+}
+
+bool SlotSandbox::UseAsCwd() const {
+    return config_.use_as_cwd;
+}
+
+int SlotSandbox::PortBase() const {
+    return port_base_;
+}
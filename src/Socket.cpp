@@ -0,0 +1,265 @@
+#include "Socket.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#    include <winsock2.h>
+#    include <ws2tcpip.h>
+#    include <afunix.h>
+#else
+#    include <netdb.h>
+#    include <netinet/in.h>
+#    include <sys/socket.h>
+#    include <sys/time.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    /**
+     * @brief 进程内只初始化一次 winsock
+     */
+    void EnsureWinsock() {
+        static bool initialized = [] {
+            WSADATA data;
+            if(WSAStartup(MAKEWORD(2, 2), &data) != 0) throw std::runtime_error("WSAStartup failed");
+            return true;
+        }();
+        (void)initialized;
+    }
+#else
+    void EnsureWinsock() {
+    }
+#endif
+
+    /**
+     * @brief 路径是否为 AF_UNIX 套接字文件
+     */
+    bool IsSocketFile(std::string const& path) {
+#ifdef _WIN32
+#    ifndef IO_REPARSE_TAG_AF_UNIX
+#        define IO_REPARSE_TAG_AF_UNIX 0x80000023L
+#    endif
+        // Windows 的套接字文件是带有 AF_UNIX 标记的重解析点
+        WIN32_FIND_DATAA data;
+        HANDLE find = FindFirstFileA(path.c_str(), &data);
+        if(find == INVALID_HANDLE_VALUE) return false;
+        FindClose(find);
+        return (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && data.dwReserved0 == IO_REPARSE_TAG_AF_UNIX;
+#else
+        std::error_code ec;
+        return std::filesystem::symlink_status(path, ec).type() == std::filesystem::file_type::socket;
+#endif
+    }
+}  // namespace
+
+Socket::Socket(Native fd): fd_(fd) {
+}
+
+Socket::Socket(Socket&& other) noexcept: fd_(std::exchange(other.fd_, kInvalid)), closed_(std::exchange(other.closed_, false)), buffer_(std::move(other.buffer_)) {
+}
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+    if(this != &other) {
+        Close();
+        fd_ = std::exchange(other.fd_, kInvalid);
+        closed_ = std::exchange(other.closed_, false);
+        buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+Socket::~Socket() {
+    Close();
+}
+
+/**
+ * @brief 在本地套接字路径上监听，残留的套接字文件会被删除
+ *
+ * @param path
+ * @return Socket
+ */
+Socket Socket::ListenLocal(std::string const& path) {
+    EnsureWinsock();
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path)) throw std::runtime_error("Socket path too long: " + path);
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    Socket listener(static_cast<Native>(socket(AF_UNIX, SOCK_STREAM, 0)));
+    if(!listener.Valid()) throw std::runtime_error("socket() failed");
+
+    // 上一次运行残留的套接字文件会导致 bind 失败；同名的其他文件不删除，说明路径配置有误
+    std::error_code ec;
+    if(std::filesystem::exists(std::filesystem::symlink_status(path, ec))) {
+        if(!IsSocketFile(path)) throw std::runtime_error("Path exists and is not a socket: " + path);
+        std::remove(path.c_str());
+    }
+    if(bind(listener.fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) throw std::runtime_error("bind() failed: " + path);
+    if(listen(listener.fd_, SOMAXCONN) != 0) throw std::runtime_error("listen() failed: " + path);
+    return listener;
+}
+
+/**
+ * @brief 在全部网卡的指定端口上监听 TCP 连接
+ *
+ * @param port
+ * @return Socket
+ */
+Socket Socket::ListenTcp(int port) {
+    EnsureWinsock();
+
+    Socket listener(static_cast<Native>(socket(AF_INET, SOCK_STREAM, 0)));
+    if(!listener.Valid()) throw std::runtime_error("socket() failed");
+
+    // 协调者重启时端口可能仍处于 TIME_WAIT
+    int reuse = 1;
+    setsockopt(listener.fd_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const*>(&reuse), sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<unsigned short>(port));
+    if(bind(listener.fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) throw std::runtime_error("bind() failed on port " + std::to_string(port));
+    if(listen(listener.fd_, SOMAXCONN) != 0) throw std::runtime_error("listen() failed on port " + std::to_string(port));
+    return listener;
+}
+
+/**
+ * @brief 连接 TCP 服务端
+ *
+ * @param host
+ * @param port
+ * @return Socket
+ */
+Socket Socket::ConnectTcp(std::string const& host, int port) {
+    EnsureWinsock();
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addrs = nullptr;
+    if(getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addrs) != 0) throw std::runtime_error("Cannot resolve host: " + host);
+
+    Socket conn;
+    for(addrinfo* ai = addrs; ai; ai = ai->ai_next) {
+        Socket candidate(static_cast<Native>(socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)));
+        if(!candidate.Valid()) continue;
+        if(connect(candidate.fd_, ai->ai_addr, static_cast<int>(ai->ai_addrlen)) == 0) {
+            conn = std::move(candidate);
+            break;
+        }
+    }
+    freeaddrinfo(addrs);
+    if(!conn.Valid()) throw std::runtime_error("Cannot connect to " + host + ":" + std::to_string(port));
+    return conn;
+}
+
+/**
+ * @brief 阻塞等待新连接
+ *
+ * @return Socket
+ */
+Socket Socket::Accept() {
+    return Socket(static_cast<Native>(accept(fd_, nullptr, nullptr)));
+}
+
+/**
+ * @brief 发送全部数据
+ *
+ * @param data
+ * @return true
+ * @return false
+ */
+bool Socket::SendAll(std::string const& data) {
+    size_t sent = 0;
+    while(sent < data.size()) {
+#ifdef _WIN32
+        int n = send(fd_, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+#else
+        // 客户端断开时不产生 SIGPIPE
+        ssize_t n = send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+#endif
+        if(n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * @brief 读取一行，不含行尾换行符
+ *
+ * @param line
+ * @return true
+ * @return false
+ */
+bool Socket::ReadLine(std::string& line) {
+    char buffer[4096];
+    size_t pos;
+    while((pos = buffer_.find('\n')) == std::string::npos) {
+        int n = static_cast<int>(recv(fd_, buffer, sizeof(buffer), 0));
+        if(n <= 0) return false;
+        buffer_.append(buffer, static_cast<size_t>(n));
+    }
+    line = buffer_.substr(0, pos);
+    buffer_.erase(0, pos + 1);
+    if(!line.empty() && line.back() == '\r') line.pop_back();
+    return true;
+}
+
+/**
+ * @brief 设置接收超时
+ *
+ * @param timeout_ms
+ */
+void Socket::SetRecvTimeout(int timeout_ms) {
+#ifdef _WIN32
+    DWORD timeout = static_cast<DWORD>(timeout_ms);
+#else
+    timeval timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+#endif
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char const*>(&timeout), sizeof(timeout));
+}
+
+void Socket::SetSendTimeout(int timeout_ms) {
+#ifdef _WIN32
+    DWORD timeout = static_cast<DWORD>(timeout_ms);
+#else
+    timeval timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+#endif
+    setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<char const*>(&timeout), sizeof(timeout));
+}
+
+void Socket::Shutdown() {
+    if(!Valid() || closed_) return;
+#ifdef _WIN32
+    // 监听套接字不能 shutdown，关闭句柄才能让阻塞的 accept 返回 INVALID_SOCKET
+    if(shutdown(fd_, SD_BOTH) != 0 && WSAGetLastError() == WSAENOTCONN) {
+        closesocket(fd_);
+        closed_ = true;
+    }
+#else
+    shutdown(fd_, SHUT_RDWR);
+#endif
+}
+
+void Socket::Close() {
+    if(!Valid()) return;
+#ifdef _WIN32
+    if(!closed_) closesocket(fd_);
+#else
+    close(fd_);
+#endif
+    fd_ = kInvalid;
+    closed_ = false;
+}
+
+bool Socket::Valid() const {
+    return fd_ != kInvalid;
+}
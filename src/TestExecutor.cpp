@@ -2,8 +2,47 @@
 
 #include <WTypesbase.h>
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+
 #include "ConcurrentResultWriter.h"
 
+namespace {
+    /**
+     * @brief 环境变量名比较，Windows 下不区分大小写
+     */
+    bool EnvNameEqual(std::string const& a, std::string const& b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return std::toupper(static_cast<unsigned char>(x)) == std::toupper(static_cast<unsigned char>(y)); });
+    }
+
+    /**
+     * @brief 以父进程环境为基础生成 CreateProcess 所需的环境块
+     *
+     * @param env 需要覆盖或新增的环境变量
+     * @return std::string 以 \0 分隔、\0\0 结尾的环境块
+     */
+    std::string BuildEnvironmentBlock(EnvList const& env) {
+        std::string block;
+        LPCH parent_env = GetEnvironmentStringsA();
+        for(LPCH p = parent_env; p && *p; p += strlen(p) + 1) {
+            std::string entry(p);
+            // 以 = 开头的是驱动器当前目录等隐藏变量，原样保留
+            size_t eq = entry.find('=', 1);
+            std::string name = entry.substr(0, eq);
+            bool overridden = std::any_of(env.begin(), env.end(), [&name](auto const& kv) { return EnvNameEqual(kv.first, name); });
+            if(!overridden) block.append(entry).push_back('\0');
+        }
+        if(parent_env) FreeEnvironmentStringsA(parent_env);
+
+        for(auto const& [name, value]: env) block.append(name + "=" + value).push_back('\0');
+        block.push_back('\0');
+        return block;
+    }
+}  // namespace
+
 /**
  * @brief Construct a new Test Executor object
  *
@@ -12,7 +51,9 @@
  * @param writer
  * @param timeout_sec
  */
-TestExecutor::TestExecutor(ThreadPool& pool, std::string const& exe_path, ConcurrentResultWriter& writer, int timeout_sec): pool_(pool), exe_path_(exe_path), writer_(writer), time_out_(timeout_sec) {
+TestExecutor::TestExecutor(ThreadPool& pool, std::string const& exe_path, ConcurrentResultWriter& writer, int timeout_sec, DispatchMode mode):
+    pool_(pool), exe_path_(exe_path), writer_(writer), time_out_(timeout_sec), mode_(mode), sandbox_(nullptr), flag_dir_(std::filesystem::temp_directory_path() / "ConcurBench"), cancelled_(false), pending_(0) {
+    if(mode_ != DispatchMode::kFilter) std::filesystem::create_directories(flag_dir_);
 }
 
 /**
@@ -22,37 +63,316 @@ TestExecutor::TestExecutor(ThreadPool& pool, std::string const& exe_path, Concur
  */
 void TestExecutor::SubmitTestBatch(std::vector<std::string> const& test_names) {
     // std::cout << "Submitting batch of " << test_names.size() << " tests\n";
-    pool_.enqueue([this, test_names] {
-        auto cmd = BuildCommand(test_names);
-        auto result = ExecuteTest(cmd, test_names);
-
-        // 处理完成, 超时, 中断的测例
-        writer_.completed_ += static_cast<int>(result.complete_tests.size() + result.timed_out_tests.size() + result.skipped_tests.size() + result.interrupted_tests.size());
-        writer_.AddResult(result);
-
-        // 记录处理结果
-        // std::cout << "Batch completed. Complete: " << result.complete_tests.size() << "Skipped: " << result.skipped_tests.size() << ", Timed out: " << result.timed_out_tests.size() << ", Interrupted: " << result.interrupted_tests.size()
-        //           << ", Remaining: " << result.remaining_tests.size() << std::endl;
-        // 重新提交剩余测例
-        if(!result.remaining_tests.empty()) {
-            SubmitTestBatch(result.remaining_tests);
+    Enqueue(test_names, [this, test_names] { return RunBatch(test_names); });
+}
+
+/**
+ * @brief 按 gtest 原生分片提交测例，每个分片交由一个线程执行
+ *
+ * gtest 只在可运行的测例 (区分大小写匹配、排除 DISABLED_) 之间轮询分片，与 TestPreprocess
+ * 得到的列表不一定一一对应，因此不预先计算各分片的测例，而以子进程实际报告的测例为准：
+ * 每个分片都以完整列表解析输出，已被其他分片报告的测例去重；全部分片结束后，
+ * 没有任何分片执行过的测例通过 flagfile 重新提交。
+ *
+ * @param test_names
+ * @param gtest_filter
+ * @param total_shards
+ */
+void TestExecutor::SubmitShards(std::vector<std::string> const& test_names, std::string const& gtest_filter, int total_shards) {
+    if(test_names.empty()) return;
+
+    struct ShardState {
+        std::mutex mtx;
+        std::unordered_set<std::string> reported;
+        int shards_left;
+    };
+    auto state = std::make_shared<ShardState>();
+    state->shards_left = total_shards;
+
+    for(int shard_index = 0; shard_index < total_shards; shard_index++) {
+        // 测例名单由子进程的输出决定，这里不传入名单，异常时也不会将测例记为中断
+        Enqueue({}, [this, state, test_names, gtest_filter, total_shards, shard_index] {
+            EnvList env = {
+              {"GTEST_TOTAL_SHARDS", std::to_string(total_shards)},
+              {"GTEST_SHARD_INDEX",  std::to_string(shard_index) },
+            };
+            ExecuteResult result{};
+            try {
+                if(!cancelled_) result = ExecuteTest(exe_path_ + " --gtest_filter=" + gtest_filter, test_names, env);
+            } catch(std::exception const& e) {
+                // 分片无法启动时，其测例在最后作为未执行的测例重新提交
+                result.output = e.what();
+            }
+            // 剩余与取消的名单是完整列表减去本分片报告的测例，包含其他分片正在执行的测例，不能计入；
+            // 取消时未执行的测例同样作为未执行的测例重新提交，由 Enqueue 记为取消
+            result.remaining_tests.clear();
+            result.cancelled_tests.clear();
+
+            std::vector<std::string> missing;
+            {
+                std::lock_guard<std::mutex> lock(state->mtx);
+                auto dedupe = [&state](std::vector<std::string>& names) {
+                    names.erase(std::remove_if(names.begin(), names.end(), [&state](std::string const& name) { return !state->reported.insert(name).second; }), names.end());
+                };
+                result.complete_tests.erase(std::remove_if(result.complete_tests.begin(), result.complete_tests.end(), [&state](auto const& res) { return !state->reported.insert(res.first).second; }), result.complete_tests.end());
+                dedupe(result.skipped_tests);
+                dedupe(result.timed_out_tests);
+                dedupe(result.interrupted_tests);
+
+                if(--state->shards_left == 0) {
+                    for(auto const& name: test_names) {
+                        if(!state->reported.count(name)) missing.push_back(name);
+                    }
+                }
+            }
+
+            // 剩余测例按分片数切分后重新提交，仍然无法运行的由 HandleResult 记为跳过或中断
+            if(!missing.empty()) {
+                size_t M = (missing.size() + total_shards - 1) / total_shards;
+                for(size_t i = 0; i < missing.size(); i += M) {
+                    SubmitTestBatch(std::vector<std::string>(missing.begin() + i, missing.begin() + std::min(i + M, missing.size())));
+                }
+            }
+            return result;
+        });
+    }
+}
+
+/**
+ * @brief 为子进程启用按工作线程划分的沙箱
+ *
+ * @param sandbox
+ */
+void TestExecutor::SetSandbox(SlotSandbox* sandbox) {
+    sandbox_ = sandbox;
+}
+
+/**
+ * @brief 取消执行
+ *
+ */
+void TestExecutor::Cancel() {
+    cancelled_ = true;
+}
+
+/**
+ * @brief 阻塞直到已提交的全部任务处理完毕
+ *
+ */
+void TestExecutor::WaitIdle() {
+    std::unique_lock<std::mutex> lock(pending_mtx_);
+    idle_cv_.wait(lock, [this] { return pending_ == 0; });
+}
+
+/**
+ * @brief 撤回已提交但尚未开始执行的测例
+ *
+ * @param test_names
+ * @return std::vector<std::string>
+ */
+std::vector<std::string> TestExecutor::Revoke(std::vector<std::string> const& test_names) {
+    std::vector<std::string> revoked;
+    std::lock_guard<std::mutex> lock(revoke_mtx_);
+    for(auto const& name: test_names) {
+        if(!started_.count(name) && revoked_.insert(name).second) revoked.push_back(name);
+    }
+    return revoked;
+}
+
+/**
+ * @brief 剔除已撤回的测例
+ *
+ * @param test_names
+ * @return std::vector<std::string>
+ */
+std::vector<std::string> TestExecutor::DropRevoked(std::vector<std::string> const& test_names) {
+    std::vector<std::string> kept;
+    std::lock_guard<std::mutex> lock(revoke_mtx_);
+    if(revoked_.empty()) return test_names;
+    for(auto const& name: test_names) {
+        if(!revoked_.erase(name)) kept.push_back(name);
+    }
+    return kept;
+}
+
+/**
+ * @brief 子进程开始执行某个测例时调用
+ *
+ * @param test_name
+ * @return true
+ * @return false
+ */
+bool TestExecutor::MarkStarted(std::string const& test_name) {
+    std::lock_guard<std::mutex> lock(revoke_mtx_);
+    if(revoked_.erase(test_name)) return false;
+    started_.insert(test_name);
+    return true;
+}
+
+/**
+ * @brief 向线程池提交任务并计数
+ *
+ * @param test_names
+ * @param run
+ */
+void TestExecutor::Enqueue(std::vector<std::string> const& test_names, std::function<ExecuteResult()> run) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        pending_++;
+    }
+    pool_.enqueue([this, test_names, run] {
+        ExecuteResult result{};
+        // 分片任务不指定名单，自行处理取消
+        if(cancelled_ && !test_names.empty()) {
+            result.cancelled_tests = DropRevoked(test_names);
+        } else {
+            try {
+                result = run();
+            } catch(std::exception const& e) {
+                // 子进程无法启动等错误，整组测例记为中断，避免调用者永远等不到结果
+                result = ExecuteResult{};
+                result.output = e.what();
+                result.interrupted_tests = test_names;
+            }
         }
+        HandleResult(test_names, result);
+
+        // 剩余测例已在 HandleResult 中重新提交，计数归零即表示全部处理完毕
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        if(--pending_ == 0) idle_cv_.notify_all();
     });
 }
 
+/**
+ * @brief 按当前下发方式执行一组测例
+ *
+ * @param batch
+ * @return ExecuteResult
+ */
+ExecuteResult TestExecutor::RunBatch(std::vector<std::string> const& batch) {
+    // 排队期间被撤回的测例不再启动
+    std::vector<std::string> test_names = DropRevoked(batch);
+    if(test_names.empty()) return ExecuteResult{};
+
+    // 分片只用于首次分配，剩余测例统一通过 flagfile 下发
+    if(mode_ == DispatchMode::kFilter) return ExecuteTest(BuildCommand(test_names), test_names);
+
+    auto flag_file = WriteFlagFile(test_names);
+    ExecuteResult result;
+    try {
+        result = ExecuteTest(BuildFlagFileCommand(flag_file), test_names);
+    } catch(...) {
+        std::filesystem::remove(flag_file);
+        throw;
+    }
+    std::filesystem::remove(flag_file);
+    return result;
+}
+
+/**
+ * @brief 记录结果，并重新提交剩余测例
+ *
+ * @param test_names
+ * @param result
+ */
+void TestExecutor::HandleResult(std::vector<std::string> const& test_names, ExecuteResult& result) {
+    // 子进程一个测例都没有处理，重复提交只会死循环。
+    // 只有正常退出且gtest报告没有可运行的测例 (如被过滤掉的DISABLED_测例) 时才记为跳过，
+    // 在第一个测例之前崩溃、缺少依赖库、flagfile 无效等情况记为中断
+    if(!test_names.empty() && result.remaining_tests.size() == test_names.size()) {
+        bool nothing_to_run = result.exit_code == 0 && result.output.find("Running 0 tests") != std::string::npos;
+        auto& target = nothing_to_run ? result.skipped_tests : result.interrupted_tests;
+        target.insert(target.end(), result.remaining_tests.begin(), result.remaining_tests.end());
+        result.remaining_tests.clear();
+    }
+
+    // 没有输出 RUN 行就得到结果的测例 (启动失败、开始前崩溃、没有可运行的测例) 未经 MarkStarted：
+    // 已被撤回的由调用者另行分配，丢弃其结果并使撤回失效；其余在回调前记为已开始，回调期间不能再被撤回
+    {
+        std::lock_guard<std::mutex> lock(revoke_mtx_);
+        if(!revoked_.empty()) {
+            auto drop = [this](std::string const& name) { return revoked_.erase(name) > 0; };
+            result.complete_tests.erase(std::remove_if(result.complete_tests.begin(), result.complete_tests.end(), [&drop](auto const& res) { return drop(res.first); }), result.complete_tests.end());
+            for(auto* names: {&result.skipped_tests, &result.timed_out_tests, &result.interrupted_tests, &result.cancelled_tests}) {
+                names->erase(std::remove_if(names->begin(), names->end(), drop), names->end());
+            }
+        }
+        for(auto const& res: result.complete_tests) started_.insert(res.first);
+        for(auto const* names: {&result.skipped_tests, &result.timed_out_tests, &result.interrupted_tests, &result.cancelled_tests}) started_.insert(names->begin(), names->end());
+    }
+
+    // 处理完成, 超时, 中断的测例
+    writer_.completed_ += static_cast<int>(result.complete_tests.size() + result.timed_out_tests.size() + result.skipped_tests.size() + result.interrupted_tests.size() + result.cancelled_tests.size());
+    writer_.AddResult(result);
+
+    // 结果已经回调给使用者后才允许再次撤回同名测例，避免撤回已有结果的测例
+    {
+        std::lock_guard<std::mutex> lock(revoke_mtx_);
+        for(auto const& res: result.complete_tests) started_.erase(res.first);
+        for(auto const* names: {&result.skipped_tests, &result.timed_out_tests, &result.interrupted_tests, &result.cancelled_tests}) {
+            for(auto const& name: *names) started_.erase(name);
+        }
+    }
+
+    // 记录处理结果
+    // std::cout << "Batch completed. Complete: " << result.complete_tests.size() << "Skipped: " << result.skipped_tests.size() << ", Timed out: " << result.timed_out_tests.size() << ", Interrupted: " << result.interrupted_tests.size()
+    //           << ", Remaining: " << result.remaining_tests.size() << std::endl;
+    // 重新提交剩余测例
+    if(!result.remaining_tests.empty()) {
+        SubmitTestBatch(result.remaining_tests);
+    }
+}
+
 std::string TestExecutor::BuildCommand(std::vector<std::string> const& test_names) {
     std::string filter;
     for(auto& test_name: test_names) filter += test_name + ":";
     return exe_path_ + " --gtest_filter=" + filter;
 }
 
+std::string TestExecutor::BuildFlagFileCommand(std::filesystem::path const& flag_file) {
+    return exe_path_ + " \"--gtest_flagfile=" + flag_file.string() + "\"";
+}
+
+/**
+ * @brief 将测例过滤条件写入临时 flagfile
+ *
+ * @param test_names
+ * @return std::filesystem::path
+ */
+std::filesystem::path TestExecutor::WriteFlagFile(std::vector<std::string> const& test_names) {
+    auto flag_file = flag_dir_ / ("filter_" + std::to_string(GetCurrentProcessId()) + "_" + std::to_string(flag_seq_++) + ".flags");
+    std::ofstream outfile(flag_file);
+    if(!outfile.is_open()) throw std::runtime_error("Cannot open flag file: " + flag_file.string());
+
+    // flagfile 中每行一个参数，测例名均为精确匹配，不含通配符
+    outfile << "--gtest_filter=";
+    for(auto const& test_name: test_names) outfile << test_name << ":";
+    outfile << "\n";
+    return flag_file;
+}
+
 /**
  * @brief 执行任务
  *
  * @param command
- * @return std::pair<int, std::string>
+ * @param test_names
+ * @param env
+ * @return ExecuteResult exit_code 为子进程退出码，超时或取消终止时为 1
  */
-ExecuteResult TestExecutor::ExecuteTest(std::string const& command, std::vector<std::string> const& test_names) {
+ExecuteResult TestExecutor::ExecuteTest(std::string const& command, std::vector<std::string> const& test_names, EnvList const& env) {
+    // 每个工作线程同一时刻只运行一个子进程，以线程编号作为沙箱槽位；在创建管道前准备，失败时没有句柄需要关闭
+    int slot = sandbox_ ? ThreadPool::CurrentWorkerIndex() : -1;
+    EnvList child_env = env;
+    std::string work_dir;
+    if(slot >= 0) {
+        EnvList sandbox_env = sandbox_->Prepare(slot);
+        child_env.insert(child_env.end(), sandbox_env.begin(), sandbox_env.end());
+        if(sandbox_->UseAsCwd()) work_dir = sandbox_->SlotDir(slot).string();
+    }
+
+    std::string env_block;
+    if(!child_env.empty()) env_block = BuildEnvironmentBlock(child_env);
+
     SECURITY_ATTRIBUTES sa;             // 定义对象 (如管道，文件，句柄) 的安全属性和继承属性
     sa.nLength = sizeof(sa);            // 必须显示这样设置
     sa.bInheritHandle = true;           // 表示子句柄可以被继承
@@ -69,30 +389,35 @@ ExecuteResult TestExecutor::ExecuteTest(std::string const& command, std::vector<
 
     PROCESS_INFORMATION pi;  // 存储新进程的信息
     // 为当前进程创建一个新的子进程
-    bool sucess = CreateProcessA(nullptr,                             // lpApplicationName: 指定要执行的可执行文件路径，nullptr时会从lpCommandLine解析
-                                 const_cast<LPSTR>(command.c_str()),  // lpCommandLine: 完整的命令行字符串，包含可执行文件路径和参数
-                                 nullptr,                             // lpProcessAttributes: 定义新进程的安全属性和继承性 (通常不需要特殊设置)
-                                 nullptr,                             // lpThreadAttributes: 定义新进程主线程的安全属性和继承性（通常不需要特殊设置）
-                                 true,                                // bInheritHandles: 是否允许子进程继承父进程的可继承句柄
-                                 CREATE_NO_WINDOW,                    // dwCreationFlags: 不显示控制台窗口
-                                 nullptr,                             // lpEnvironment: 指定子进程的环境变量，nullptr表示继承父进程
-                                 nullptr,                             // lpCurrentDirectory: 指定子进程的工作目录，nullpte表示继承父进程
-                                 &si,                                 // lpStartupInfo: 指向 STARTUPINFOA 结构体的指针，包含标准句柄重定向等配置
-                                 &pi                                  // lpProcessInformation: 接收新进程的句柄和ID，后续用于管理进程
+    bool sucess = CreateProcessA(nullptr,                                         // lpApplicationName: 指定要执行的可执行文件路径，nullptr时会从lpCommandLine解析
+                                 const_cast<LPSTR>(command.c_str()),              // lpCommandLine: 完整的命令行字符串，包含可执行文件路径和参数
+                                 nullptr,                                         // lpProcessAttributes: 定义新进程的安全属性和继承性 (通常不需要特殊设置)
+                                 nullptr,                                         // lpThreadAttributes: 定义新进程主线程的安全属性和继承性（通常不需要特殊设置）
+                                 true,                                            // bInheritHandles: 是否允许子进程继承父进程的可继承句柄
+                                 CREATE_NO_WINDOW,                                // dwCreationFlags: 不显示控制台窗口
+                                 child_env.empty() ? nullptr : env_block.data(),  // lpEnvironment: 指定子进程的环境变量，nullptr表示继承父进程
+                                 work_dir.empty() ? nullptr : work_dir.c_str(),   // lpCurrentDirectory: 指定子进程的工作目录，nullpte表示继承父进程
+                                 &si,                                             // lpStartupInfo: 指向 STARTUPINFOA 结构体的指针，包含标准句柄重定向等配置
+                                 &pi                                              // lpProcessInformation: 接收新进程的句柄和ID，后续用于管理进程
     );
 
     if(!sucess) {
         CloseHandle(hOutputRead);
+        CloseHandle(hOutputWrite);
+        if(slot >= 0) sandbox_->Release(slot);
         throw std::runtime_error("CreateProcess failed");
     }
 
     CloseHandle(hOutputWrite);  // 父进程无需写端，立即关闭
 
-    std::vector<std::string> remaining_tests = test_names;
+    std::unordered_set<std::string> pending(test_names.begin(), test_names.end());  // 尚未结束的测例，分片模式下为完整列表，需要常数时间查找
+    std::vector<std::string> remaining_tests;
     std::vector<std::pair<std::string, std::string>> completed_tests;
     std::vector<std::string> skipped_tests;
     std::vector<std::string> timed_out_tests;
     std::vector<std::string> interrupted_tests;
+    std::vector<std::string> cancelled_tests;
+    std::unordered_map<std::string, long long> durations_ms;
     std::string current_test;
     auto start_time = std::chrono::steady_clock::now();
 
@@ -100,23 +425,16 @@ ExecuteResult TestExecutor::ExecuteTest(std::string const& command, std::vector<
     char buffer[4096];
     DWORD bytesRead;  // 保存ReadFile实际读取的字节数
     std::string output;
+    size_t parsed = 0;  // output 中已解析的长度，每轮只解析新增的输出
     bool process_exited = false;
+    DWORD exit_code = 0;
 
     while(true) {
-        // 非阻塞检查子进程是否已经退出
-        DWORD exit_code;
-        if(GetExitCodeProcess(pi.hProcess, &exit_code) && exit_code != STILL_ACTIVE) {
+        // 非阻塞检查子进程是否已经退出，退出前写入的输出在本轮解析完后再判断是否中断
+        DWORD code;
+        if(GetExitCodeProcess(pi.hProcess, &code) && code != STILL_ACTIVE) {
             process_exited = true;
-            // 检测异常退出 (非正常结束且非超时终止)
-            if(exit_code != 0 && timed_out_tests.empty()) {
-                if(!current_test.empty()) {
-                    interrupted_tests.push_back(current_test);
-                    auto it = std::find(remaining_tests.begin(), remaining_tests.end(), current_test);
-                    if(it != remaining_tests.end()) {
-                        remaining_tests.erase(it);
-                    }
-                }
-            }
+            exit_code = code;
         }
 
         // 非阻塞读取，首先检查管道中是否有数据可以读取
@@ -126,55 +444,91 @@ ExecuteResult TestExecutor::ExecuteTest(std::string const& command, std::vector<
             output.append(buffer, bytesRead);
         }
 
-        // 解析输出
-        std::istringstream iss(output);
-        std::string line;
-        while(std::getline(iss, line)) {
-            if(line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+        // 解析新增的完整行，子进程退出后不会再有输出，末尾不完整的行一并解析
+        size_t parse_end = output.rfind('\n');
+        parse_end = process_exited ? output.size() : (parse_end == std::string::npos ? parsed : parse_end + 1);
+        std::string revoked_test;
+        while(parsed < parse_end) {
+            size_t line_end = std::min(output.find('\n', parsed), parse_end);
+            std::string line = output.substr(parsed, line_end - parsed);
+            parsed = std::min(line_end + 1, parse_end);
+            if(!line.empty() && line.back() == '\r') line.pop_back();
             if(line.find("[ RUN      ]") != std::string::npos) {
                 current_test = line.substr(13);
                 start_time = std::chrono::steady_clock::now();
+                // 开始执行已撤回的测例时停止解析，由下面终止子进程
+                if(pending.count(current_test) && !MarkStarted(current_test)) {
+                    revoked_test = current_test;
+                    break;
+                }
             } else if(line.find("[       OK ]") != std::string::npos || line.find("[  FAILED  ]") != std::string::npos) {
-                if(!current_test.empty()) {
-                    auto it = std::find(remaining_tests.begin(), remaining_tests.end(), current_test);
-                    if(it != remaining_tests.end()) {
-                        completed_tests.push_back({current_test, line.find("[       OK ]") != std::string::npos ? "Passed" : "Failed"});
-                        remaining_tests.erase(it);
+                if(!current_test.empty() && pending.erase(current_test)) {
+                    completed_tests.push_back({current_test, line.find("[       OK ]") != std::string::npos ? "Passed" : "Failed"});
+                    // 结束行形如 "[       OK ] Suite.Name (12 ms)"
+                    size_t ms_begin = line.rfind('(');
+                    if(ms_begin != std::string::npos && line.find(" ms)", ms_begin) != std::string::npos) {
+                        durations_ms[current_test] = std::atoll(line.c_str() + ms_begin + 1);
                     }
                 }
                 current_test.clear();
             } else if(line.find("[  SKIPPED ]") != std::string::npos) {
-                if(!current_test.empty()) {
-                    auto it = std::find(remaining_tests.begin(), remaining_tests.end(), current_test);
-                    if(it != remaining_tests.end()) {
-                        skipped_tests.push_back(current_test);
-                        remaining_tests.erase(it);
-                    }
-                }
+                if(!current_test.empty() && pending.erase(current_test)) skipped_tests.push_back(current_test);
                 current_test.clear();
             }
         }
 
+        // 测例已被撤回，终止子进程，其余未执行的测例由 HandleResult 重新提交
+        if(!revoked_test.empty()) {
+            TerminateProcess(pi.hProcess, 1);
+            exit_code = 1;
+            pending.erase(revoked_test);
+            current_test.clear();
+            break;
+        }
+
+        if(process_exited) {
+            // 检测异常退出：解析完全部输出后仍有测例未结束，说明子进程在执行该测例时崩溃
+            if(exit_code != 0 && !current_test.empty()) {
+                interrupted_tests.push_back(current_test);
+                pending.erase(current_test);
+            }
+            break;
+        }
+
+        // 取消执行，终止子进程，未完成的测例记为取消
+        if(cancelled_) {
+            TerminateProcess(pi.hProcess, 1);
+            exit_code = 1;
+            for(auto const& name: test_names) {
+                if(pending.count(name)) cancelled_tests.push_back(name);
+            }
+            pending.clear();
+            current_test.clear();
+            break;
+        }
+
         // 检查超时
         if(!current_test.empty()) {
             auto now = std::chrono::steady_clock::now();
             auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - start_time).count();
             if(elapsed >= time_out_) {
                 TerminateProcess(pi.hProcess, 1);
+                exit_code = 1;
                 timed_out_tests.push_back(current_test);
-                auto it = std::find(remaining_tests.begin(), remaining_tests.end(), current_test);
-                if(it != remaining_tests.end()) {
-                    remaining_tests.erase(it);
-                }
+                pending.erase(current_test);
                 current_test.clear();
                 break;
             }
         }
 
-        if(process_exited) break;
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
+    // 剩余测例保持下发时的顺序
+    for(auto const& name: test_names) {
+        if(pending.count(name)) remaining_tests.push_back(name);
+    }
+
     // 读取剩余输出
     while(ReadFile(hOutputRead, buffer, sizeof(buffer), &bytesRead, NULL) && bytesRead > 0) {
         output.append(buffer, bytesRead);
@@ -183,6 +537,7 @@ ExecuteResult TestExecutor::ExecuteTest(std::string const& command, std::vector<
     CloseHandle(pi.hProcess);
     CloseHandle(pi.hThread);
     CloseHandle(hOutputRead);
+    if(slot >= 0) sandbox_->Release(slot);
 
-    return {0, output, completed_tests, skipped_tests, timed_out_tests, remaining_tests, interrupted_tests};
+    return {static_cast<int>(exit_code), output, completed_tests, skipped_tests, timed_out_tests, remaining_tests, interrupted_tests, cancelled_tests, durations_ms};
 }
\ No newline at end of file
@@ -26,6 +26,21 @@ void TestPreprocess::GetTests() {
     FilterAndWriteResults(all_tests, filters);
 }
 
+/**
+ * @brief 读取 GetTests 写入的测例列表
+ *
+ * @return std::vector<std::string>
+ */
+std::vector<std::string> TestPreprocess::ReadTests() const {
+    std::vector<std::string> test_names;
+    std::ifstream infile(out_file_);
+    std::string line;
+    while(std::getline(infile, line)) {
+        if(!line.empty()) test_names.push_back(line);
+    }
+    return test_names;
+}
+
 /**
  * @brief 获得全部的tests name
  *
@@ -0,0 +1,228 @@
+#include "TestRunner.h"
+
+#include <algorithm>
+
+#include "TestPreprocess.h"
+
+/**
+ * @brief 按测例状态计数
+ *
+ * @param status
+ */
+void RunSummary::Record(std::string const& status) {
+    if(status == "Passed")
+        passed++;
+    else if(status == "Failed")
+        failed++;
+    else if(status == "Skipped")
+        skipped++;
+    else if(status == "Timed_out")
+        timed_out++;
+    else if(status == "Interrupted")
+        interrupted++;
+    else if(status == "Cancelled")
+        cancelled++;
+}
+
+/**
+ * @brief 一次运行的内部状态，由驱动线程与全部 RunHandle 共享
+ *
+ */
+struct RunState {
+    RunState(RunConfig const& config, std::shared_ptr<ThreadPool> pool, int thread_num);
+
+    ~RunState();
+
+    /**
+     * @brief 驱动线程：获取测例、提交任务并等待全部处理完毕
+     *
+     */
+    void Drive();
+
+    /**
+     * @brief 单个测例结果回调
+     *
+     * @param result
+     */
+    void OnResult(TestResult const& result);
+
+    RunConfig config_;
+    int thread_num_;
+    std::shared_ptr<ThreadPool> pool_;
+    std::unique_ptr<ConcurrentResultWriter> writer_;
+    std::unique_ptr<SlotSandbox> sandbox_;
+    std::unique_ptr<TestExecutor> executor_;
+
+    std::mutex mtx_;
+    RunSummary summary_;
+    std::promise<RunSummary> promise_;
+    std::shared_future<RunSummary> future_;
+    std::thread driver_;
+};
+
+RunState::RunState(RunConfig const& config, std::shared_ptr<ThreadPool> pool, int thread_num): config_(config), thread_num_(thread_num), pool_(std::move(pool)), future_(promise_.get_future().share()) {
+    if(config_.out_dir.empty()) config_.out_dir = std::filesystem::path(config_.exe_path).parent_path() / "output";
+    std::filesystem::create_directories(config_.out_dir);
+
+    writer_ = std::make_unique<ConcurrentResultWriter>((config_.out_dir / "result.txt").string());
+    writer_->total_ = 0;
+    writer_->completed_ = 0;
+    writer_->SetListener([this](TestResult const& result) { OnResult(result); });
+    executor_ = std::make_unique<TestExecutor>(*pool_, config_.exe_path, *writer_, config_.timeout_sec, config_.dispatch_mode);
+    if(config_.sandbox.enabled) {
+        sandbox_ = std::make_unique<SlotSandbox>(config_.sandbox, thread_num_);
+        executor_->SetSandbox(sandbox_.get());
+    }
+}
+
+RunState::~RunState() {
+    executor_->Cancel();
+    if(!driver_.joinable()) return;
+    // 驱动线程释放最后一份引用时在自身中析构，不能 join 自己
+    if(driver_.get_id() == std::this_thread::get_id())
+        driver_.detach();
+    else
+        driver_.join();
+}
+
+/**
+ * @brief 驱动线程
+ *
+ */
+void RunState::Drive() {
+    auto start_time = std::chrono::steady_clock::now();
+    try {
+        std::vector<std::string> test_names = config_.test_names;
+        if(test_names.empty()) {
+            TestPreprocess tp(config_.gtest_filter, config_.exe_path, (config_.out_dir / "test_name.txt").string());
+            tp.GetTests();
+            test_names = tp.ReadTests();
+        }
+
+        size_t repeat = static_cast<size_t>(std::max(1, config_.repeat));
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            summary_.total = test_names.size() * repeat;
+        }
+        writer_->total_ = static_cast<int>(test_names.size() * repeat);
+
+        // 每一轮单独切分，保证同一组内不出现重复测例
+        size_t M = config_.batch_size ? config_.batch_size : std::max<size_t>(1, test_names.size() * repeat / thread_num_ / 10);
+        for(size_t r = 0; r < repeat; r++) {
+            if(config_.dispatch_mode == DispatchMode::kShard && config_.test_names.empty()) {
+                // 按线程数静态均分，由gtest在子进程内完成分片；分片依赖 gtest_filter 的过滤顺序，指定测例时不可用
+                executor_->SubmitShards(test_names, config_.gtest_filter, thread_num_);
+                continue;
+            }
+            // 提交任务, 一组M个
+            for(size_t i = 0; i < test_names.size(); i += M) {
+                executor_->SubmitTestBatch(std::vector<std::string>(test_names.begin() + i, test_names.begin() + std::min(i + M, test_names.size())));
+            }
+        }
+
+        // 事件驱动等待，最后一组处理完毕立即返回
+        executor_->WaitIdle();
+        {
+            std::lock_guard<std::mutex> lock(writer_->mtx_);
+            writer_->outfile_.flush();
+        }
+
+        RunSummary summary;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            summary_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+            summary = summary_;
+        }
+        if(config_.on_complete) config_.on_complete(summary);
+        promise_.set_value(summary);
+    } catch(...) {
+        // 提交过程中出错时，已提交的任务仍引用本状态，需等待其结束
+        executor_->Cancel();
+        executor_->WaitIdle();
+        promise_.set_exception(std::current_exception());
+    }
+}
+
+/**
+ * @brief 单个测例结果回调
+ *
+ * @param result
+ */
+void RunState::OnResult(TestResult const& result) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        summary_.Record(result.status);
+    }
+    if(config_.on_result) config_.on_result(result);
+}
+
+RunHandle::RunHandle(std::shared_ptr<RunState> state): state_(std::move(state)) {
+}
+
+/**
+ * @brief 阻塞等待运行结束
+ *
+ * @return RunSummary
+ */
+RunSummary RunHandle::Wait() const {
+    return state_->future_.get();
+}
+
+/**
+ * @brief 在给定时间内等待运行结束
+ *
+ * @param timeout
+ * @return true
+ * @return false
+ */
+bool RunHandle::WaitFor(std::chrono::milliseconds timeout) const {
+    return state_->future_.wait_for(timeout) == std::future_status::ready;
+}
+
+std::shared_future<RunSummary> RunHandle::Future() const {
+    return state_->future_;
+}
+
+/**
+ * @brief 取消运行
+ *
+ */
+void RunHandle::Cancel() {
+    state_->executor_->Cancel();
+}
+
+int RunHandle::Completed() const {
+    return state_->writer_->completed_;
+}
+
+int RunHandle::Total() const {
+    return state_->writer_->total_;
+}
+
+/**
+ * @brief Construct a new Test Runner object
+ *
+ * @param thread_num
+ */
+TestRunner::TestRunner(int thread_num): thread_num_(thread_num), pool_(std::make_shared<ThreadPool>(thread_num)) {
+}
+
+/**
+ * @brief 异步开始一次运行
+ *
+ * @param config
+ * @return RunHandle
+ */
+RunHandle TestRunner::Start(RunConfig const& config) {
+    auto state = std::make_shared<RunState>(config, pool_, thread_num_);
+    // 驱动线程持有一份引用直到运行结束，任务执行期间 RunState 不会在工作线程中析构
+    state->driver_ = std::thread([state]() mutable {
+        state->Drive();
+        // 回调可能捕获了句柄，释放回调以打破引用环
+        state->config_.on_result = nullptr;
+        state->config_.on_complete = nullptr;
+        state.reset();
+    });
+    // 句柄的全部副本共享一份引用，最后一个副本销毁时只请求取消，不等待驱动线程
+    return RunHandle(std::shared_ptr<RunState>(state.get(), [state](RunState* raw) { raw->executor_->Cancel(); }));
+}
@@ -1,4 +1,9 @@
 #include "ThreadPool.h"
+
+namespace {
+    thread_local int tls_worker_index = -1;  // 工作线程编号，由工作线程启动时设置
+}  // namespace
+
 /**
  * @brief 构造函数
  *
@@ -7,8 +12,9 @@
 ThreadPool::ThreadPool(size_t threads): stop(false) {
     // 创建指定数量的工作线程
     for(size_t i = 0; i < threads; i++) {
-        // [this]() -> void {}的简写
-        workers.emplace_back([this] {
+        // [this, i]() -> void {}的简写
+        workers.emplace_back([this, i] {
+            tls_worker_index = static_cast<int>(i);
             while(true) {
                 std::function<void()> task;
                 {
@@ -45,4 +51,13 @@ ThreadPool::~ThreadPool() {
     }
     condition.notify_all();                           // 唤醒所有线程
     for(std::thread& worker: workers) worker.join();  // 主线程（调用线程）将阻塞直到所有工作线程执行完毕
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 当前线程在所属线程池中的编号
+ *
+ * @return int
+ */
+int ThreadPool::CurrentWorkerIndex() {
+    return tls_worker_index;
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Agent.h"
+#include "Coordinator.h"
+#include "Socket.h"
+
+namespace {
+    constexpr int kPort = 39411;
+    constexpr size_t kFakeTestCount = 11;  // FakeTests 中 10 个通过、1 个失败
+
+    std::filesystem::path TempDir(std::string const& name) {
+        auto dir = std::filesystem::temp_directory_path() / "ConcurBenchTests" / name;
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        return dir;
+    }
+
+    RunConfig FakeConfig(std::string const& name) {
+        RunConfig config;
+        config.exe_path = FAKE_TESTS_PATH;
+        config.out_dir = TempDir(name);
+        config.timeout_sec = 10;
+        return config;
+    }
+
+    /**
+     * @brief 记录协调者收到的每条结果，检查测例不重复、不遗漏
+     */
+    struct ResultLog {
+        std::mutex mtx;
+        std::map<std::string, int> counts;
+
+        void Attach(RunConfig& config) {
+            config.on_result = [this](TestResult const& result) {
+                std::lock_guard<std::mutex> lock(mtx);
+                counts[result.name]++;
+            };
+        }
+
+        void ExpectEachOnce(size_t total) {
+            std::lock_guard<std::mutex> lock(mtx);
+            EXPECT_EQ(counts.size(), total);
+            for(auto const& [name, count]: counts) EXPECT_EQ(count, 1) << name;
+        }
+    };
+
+    std::future<bool> StartAgent(std::string const& name, int port, int thread_num, int heartbeat_ms = 5000) {
+        return std::async(std::launch::async, [name, port, thread_num, heartbeat_ms] {
+            Agent agent(FakeConfig(name), "127.0.0.1", port, thread_num, heartbeat_ms);
+            return agent.Run();
+        });
+    }
+
+    /**
+     * @brief 读取下一行并检查命令
+     */
+    std::vector<std::string> Expect(Socket& socket, std::string const& command) {
+        std::string line;
+        EXPECT_TRUE(socket.ReadLine(line));
+        EXPECT_TRUE(line == command || line.rfind(command + " ", 0) == 0) << line;
+
+        std::vector<std::string> fields;
+        if(line.size() <= command.size()) return fields;
+        size_t begin = command.size() + 1;
+        while(begin <= line.size()) {
+            size_t end = line.find('\t', begin);
+            if(end == std::string::npos) end = line.size();
+            fields.push_back(line.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        return fields;
+    }
+}  // namespace
+
+TEST(DistributedTest, AgentsRunEveryTestOnce) {
+    RunConfig config = FakeConfig("coordinator");
+    ResultLog log;
+    log.Attach(config);
+    Coordinator coordinator(config, kPort);
+    auto run = std::async(std::launch::async, [&coordinator] { return coordinator.Run(); });
+
+    auto agent_a = StartAgent("agent_a", kPort, 2);
+    auto agent_b = StartAgent("agent_b", kPort, 2);
+    EXPECT_TRUE(agent_a.get());
+    EXPECT_TRUE(agent_b.get());
+
+    RunSummary summary = run.get();
+    EXPECT_EQ(summary.total, kFakeTestCount);
+    EXPECT_EQ(summary.passed, kFakeTestCount - 1);
+    EXPECT_EQ(summary.failed, 1u);
+    log.ExpectEachOnce(kFakeTestCount);
+}
+
+TEST(DistributedTest, LostAgentBatchIsRequeued) {
+    RunConfig config = FakeConfig("coordinator");
+    ResultLog log;
+    log.Attach(config);
+    Coordinator coordinator(config, kPort + 1);
+    auto run = std::async(std::launch::async, [&coordinator] { return coordinator.Run(); });
+
+    {
+        // 拉取一个批次后断开连接
+        Socket lost = Socket::ConnectTcp("127.0.0.1", kPort + 1);
+        ASSERT_TRUE(lost.SendAll("HELLO 1\nPULL\n"));
+        EXPECT_GT(Expect(lost, "BATCH").size(), 1u);
+    }
+
+    auto agent = StartAgent("agent", kPort + 1, 2);
+    EXPECT_TRUE(agent.get());
+
+    RunSummary summary = run.get();
+    EXPECT_EQ(summary.passed + summary.failed, kFakeTestCount);
+    log.ExpectEachOnce(kFakeTestCount);
+}
+
+TEST(DistributedTest, SilentAgentTimesOut) {
+    RunConfig config = FakeConfig("coordinator");
+    ResultLog log;
+    log.Attach(config);
+    Coordinator coordinator(config, kPort + 2, 500);
+    auto run = std::async(std::launch::async, [&coordinator] { return coordinator.Run(); });
+
+    // 拉取一个批次后保持连接但不再发送任何消息，超时后批次重新入队
+    Socket silent = Socket::ConnectTcp("127.0.0.1", kPort + 2);
+    ASSERT_TRUE(silent.SendAll("HELLO 1\nPULL\n"));
+    EXPECT_GT(Expect(silent, "BATCH").size(), 1u);
+
+    auto agent = StartAgent("agent", kPort + 2, 2, 100);
+    EXPECT_TRUE(agent.get());
+
+    RunSummary summary = run.get();
+    EXPECT_EQ(summary.passed + summary.failed, kFakeTestCount);
+    log.ExpectEachOnce(kFakeTestCount);
+}
+
+TEST(DistributedTest, IdleAgentStealsUnstartedTail) {
+    RunConfig config;
+    config.out_dir = TempDir("coordinator");
+    config.test_names = {"S.T0", "S.T1", "S.T2", "S.T3", "S.T4", "S.T5"};
+    ResultLog log;
+    log.Attach(config);
+    Coordinator coordinator(config, kPort + 3);
+    auto run = std::async(std::launch::async, [&coordinator] { return coordinator.Run(); });
+
+    // 第一个 Agent 拉空队列，最大的批次为 S.T0 S.T1 S.T2
+    Socket busy = Socket::ConnectTcp("127.0.0.1", kPort + 3);
+    ASSERT_TRUE(busy.SendAll("HELLO 1\nPULL\nPULL\nPULL\nPULL\n"));
+    std::vector<std::vector<std::string>> batches;
+    for(int i = 0; i < 4; i++) batches.push_back(Expect(busy, "BATCH"));
+    ASSERT_EQ(batches[0], (std::vector<std::string>{batches[0][0], "S.T0", "S.T1", "S.T2"}));
+
+    // 队列为空时空闲的 Agent 拉取，协调者请求撤回最大批次的后一半
+    Socket idle = Socket::ConnectTcp("127.0.0.1", kPort + 3);
+    ASSERT_TRUE(idle.SendAll("HELLO 1\nPULL\n"));
+    EXPECT_EQ(Expect(busy, "REVOKE"), (std::vector<std::string>{batches[0][0], "S.T2"}));
+    ASSERT_TRUE(busy.SendAll("REVOKED " + batches[0][0] + "\tS.T2\n"));
+
+    std::vector<std::string> stolen = Expect(idle, "BATCH");
+    ASSERT_EQ(stolen.size(), 2u);
+    EXPECT_EQ(stolen[1], "S.T2");
+    ASSERT_TRUE(idle.SendAll("RESULT " + stolen[0] + "\tS.T2\tPassed\t1\nDONE " + stolen[0] + "\n"));
+
+    // 撤回的测例不再计入原批次，原 Agent 为其余测例回报结果即可结束
+    std::string results;
+    for(auto const& batch: batches) {
+        for(size_t i = 1; i < batch.size(); i++) {
+            if(batch[i] != "S.T2") results += "RESULT " + batch[0] + "\t" + batch[i] + "\tPassed\t1\n";
+        }
+        results += "DONE " + batch[0] + "\n";
+    }
+    ASSERT_TRUE(busy.SendAll(results));
+
+    RunSummary summary = run.get();
+    EXPECT_EQ(summary.passed, config.test_names.size());
+    log.ExpectEachOnce(config.test_names.size());
+    Expect(busy, "BYE");
+}
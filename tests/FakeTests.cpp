@@ -0,0 +1,25 @@
+// 分布式测试使用的被测程序：10 个通过的测例与一个失败的测例，与 DistributedTest.cpp 中的 kFakeTestCount 保持一致
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#define FAKE_TEST(name, ms)                                          \
+    TEST(FakeSuite, name) {                                          \
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms)); \
+    }
+
+FAKE_TEST(Pass0, 50)
+FAKE_TEST(Pass1, 50)
+FAKE_TEST(Pass2, 50)
+FAKE_TEST(Pass3, 50)
+FAKE_TEST(Pass4, 50)
+FAKE_TEST(Pass5, 50)
+FAKE_TEST(Pass6, 50)
+FAKE_TEST(Pass7, 50)
+FAKE_TEST(Pass8, 50)
+FAKE_TEST(Pass9, 50)
+
+TEST(FakeSuite, Fail) {
+    FAIL() << "expected failure";
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "PerfReport.h"
+
+// 期望值按正态近似的定义手工计算：U = R1 - n1(n1+1)/2，
+// Var(U) = n1 n2 / 12 * ((N + 1) - Σ(t³ - t) / (N(N - 1)))，z = (U - n1 n2 / 2 - 0.5) / sqrt(Var(U))
+
+TEST(MannWhitneyGreaterTest, SeparatedSamples) {
+    // R1 = 40, U = 25, Var(U) = 22.9167, z = 2.5067
+    EXPECT_NEAR(PerfReport::MannWhitneyGreater({6, 7, 8, 9, 10}, {1, 2, 3, 4, 5}), 0.0060929, 1e-6);
+    // 备择假设为单侧，方向相反时 p 值接近 1
+    EXPECT_NEAR(PerfReport::MannWhitneyGreater({1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}), 0.9966923, 1e-6);
+}
+
+TEST(MannWhitneyGreaterTest, TiedSamples) {
+    // 结：10 x4, 11 x3, 12 x3, 13 x2，Σ(t³ - t) = 114；R1 = 76, U = 48, Var(U) = 58.6923, z = 3.0022
+    EXPECT_NEAR(PerfReport::MannWhitneyGreater({11, 12, 13, 12, 14, 13, 12}, {10, 10, 11, 10, 9, 10, 11}), 0.0013403, 1e-6);
+    // 结：3 x4, 4 x3, 2 x2, 5 x2，Σ(t³ - t) = 96；R1 = 52, U = 31, Var(U) = 36.8182, z = 2.0601
+    EXPECT_NEAR(PerfReport::MannWhitneyGreater({3, 3, 4, 4, 5, 5}, {1, 2, 2, 3, 3, 4}), 0.0196966, 1e-6);
+}
+
+TEST(MannWhitneyGreaterTest, IdenticalSamples) {
+    EXPECT_NEAR(PerfReport::MannWhitneyGreater({10, 10, 11, 10, 9, 10, 11}, {10, 10, 11, 10, 9, 10, 11}), 0.5286291, 1e-6);
+    // 全部样本相同时方差为 0，不判定回退
+    EXPECT_EQ(PerfReport::MannWhitneyGreater({2, 2, 2, 2, 2}, {2, 2, 2, 2, 2}), 1);
+}
+
+TEST(MannWhitneyGreaterTest, TooFewSamples) {
+    EXPECT_EQ(PerfReport::MannWhitneyGreater({6, 7, 8, 9}, {1, 2, 3, 4, 5}), 1);
+    EXPECT_EQ(PerfReport::MannWhitneyGreater({6, 7, 8, 9, 10}, {1, 2, 3, 4}), 1);
+}
+
+TEST(PerfReportTest, Quantiles) {
+    PerfReport report;
+    for(int i = 10; i <= 20; i++) report.AddSample("Suite.Test", i);
+    report.AddSample("Suite.Even", 1);
+    report.AddSample("Suite.Even", 4);
+
+    auto stats = report.Analyze();
+    ASSERT_EQ(stats.size(), 2u);
+    // 按测例名排序
+    EXPECT_EQ(stats[0].name, "Suite.Even");
+    EXPECT_DOUBLE_EQ(stats[0].median_ms, 2.5);
+    EXPECT_DOUBLE_EQ(stats[0].p95_ms, 3.85);
+
+    EXPECT_EQ(stats[1].name, "Suite.Test");
+    EXPECT_DOUBLE_EQ(stats[1].mean_ms, 15);
+    EXPECT_DOUBLE_EQ(stats[1].median_ms, 15);
+    EXPECT_DOUBLE_EQ(stats[1].p95_ms, 19.5);
+    EXPECT_DOUBLE_EQ(stats[1].variance, 11);
+    EXPECT_FALSE(stats[1].has_baseline);
+}
+
+TEST(PerfReportTest, BaselineRoundTrip) {
+    auto path = std::filesystem::temp_directory_path() / "ConcurBenchTests_baseline.tsv";
+    {
+        PerfReport baseline;
+        for(int i = 10; i <= 20; i++) baseline.AddSample("Suite.Slower", i);
+        for(int i = 10; i <= 14; i++) baseline.AddSample("Suite.Same", i);
+        baseline.AddSample("Suite.Sparse", 10);
+        PerfReport::Write(path, baseline.Analyze());
+    }
+
+    PerfReport report;
+    report.LoadBaseline(path);
+    std::filesystem::remove(path);
+    EXPECT_EQ(report.CountUnderSampledBaselines(), 1u);
+
+    for(int i = 30; i <= 35; i++) report.AddSample("Suite.Slower", i);
+    for(int i = 10; i <= 14; i++) report.AddSample("Suite.Same", i);
+    for(int i = 30; i <= 35; i++) report.AddSample("Suite.Sparse", i);
+    auto stats = report.Analyze(0.01, 0.05);
+    ASSERT_EQ(stats.size(), 3u);
+
+    EXPECT_EQ(stats[0].name, "Suite.Same");
+    EXPECT_TRUE(stats[0].has_baseline);
+    EXPECT_FALSE(stats[0].regressed);
+
+    EXPECT_EQ(stats[1].name, "Suite.Slower");
+    EXPECT_DOUBLE_EQ(stats[1].baseline_median_ms, 15);
+    EXPECT_LT(stats[1].p_value, 0.01);
+    EXPECT_TRUE(stats[1].regressed);
+
+    // 基线只有一个样本，无法判定
+    EXPECT_EQ(stats[2].name, "Suite.Sparse");
+    EXPECT_EQ(stats[2].p_value, 1);
+    EXPECT_FALSE(stats[2].regressed);
+}
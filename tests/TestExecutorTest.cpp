@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ConcurrentResultWriter.h"
+#include "TestExecutor.h"
+
+namespace {
+    std::filesystem::path ResultFile(std::string const& name) {
+        auto dir = std::filesystem::temp_directory_path() / "ConcurBenchTests" / name;
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        return dir / "result.txt";
+    }
+}  // namespace
+
+TEST(TestExecutorTest, ResultWithoutRunLineCannotBeRevoked) {
+    // gtest 报告没有可运行的测例时不会输出 RUN 行，结果回调期间撤回必须失败，否则再次下发的同名测例会被静默丢弃
+    std::string const name = "FakeSuite.Missing";
+    ThreadPool pool(1);
+    ConcurrentResultWriter writer(ResultFile("executor_revoke").string());
+    TestExecutor executor(pool, FAKE_TESTS_PATH, writer, 10);
+
+    std::mutex mtx;
+    std::vector<std::string> statuses;
+    std::vector<std::string> revoked;
+    writer.SetListener([&](TestResult const& result) {
+        std::lock_guard<std::mutex> lock(mtx);
+        statuses.push_back(result.status);
+        if(statuses.size() == 1) revoked = executor.Revoke({result.name});
+    });
+
+    executor.SubmitTestBatch({name});
+    executor.WaitIdle();
+    executor.SubmitTestBatch({name});
+    executor.WaitIdle();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    EXPECT_TRUE(revoked.empty());
+    EXPECT_EQ(statuses, (std::vector<std::string>{"Skipped", "Skipped"}));
+}